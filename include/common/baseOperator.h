@@ -1,6 +1,9 @@
 #ifndef _BASE_OPERATOR_H_
 #define _BASE_OPERATOR_H_
 #include "type.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace dawn
 {
@@ -23,5 +26,21 @@ inline int getTopBitPosition(uint32_t number)
   return 0;
 }
 
+/// @brief Position of the lowest set bit, number must not be zero.
+inline int getBottomBitPosition(uint64_t number)
+{
+  return __builtin_ctzll(number);
+}
+
+/// @brief Hint CPU that caller is in a spin loop.
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 }
 #endif
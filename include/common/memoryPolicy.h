@@ -0,0 +1,41 @@
+#ifndef _MEMORY_POLICY_H_
+#define _MEMORY_POLICY_H_
+#include <cstddef>
+
+namespace dawn
+{
+  constexpr const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /// @brief How pages of big regions are backed. It covers shm segments and slabs of memory pool.
+  /// @note Policy is process wide. Set it before memPoolInit() and before any topic is opened,
+  ///       regions which are already created keep their pages.
+  struct memoryPolicy
+  {
+    /// @brief Back regions with 2M hugepages. Slabs use reserved hugepages and fall back to transparent hugepages.
+    ///        Shm segments live on tmpfs, so they only get transparent hugepage advice.
+    bool hugePage_ = false;
+    /// @brief Fault in every page when region is created or mapped.
+    bool prefault_ = false;
+    /// @brief Lock pages of region in RAM, it is limited by RLIMIT_MEMLOCK.
+    bool lock_ = false;
+  };
+
+  void setMemoryPolicy(const memoryPolicy &policy);
+
+  memoryPolicy getMemoryPolicy();
+
+  /// @brief Apply memory policy to a mapped shared region. Failures are only logged.
+  /// @param addr page aligned address of region.
+  /// @param len
+  void applyMemoryPolicy(void *addr, size_t len);
+
+  /// @brief Allocate a zero filled private region following memory policy.
+  /// @param len requested length, it is updated to the length really mapped.
+  /// @return nullptr if allocation failed.
+  void* allocRegion(size_t &len);
+
+  /// @brief Release a region from allocRegion().
+  void freeRegion(void *addr, size_t len);
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define _MEMORY_POOL_H_
 #include <atomic>
 #include <list>
+#include <utility>
 #include <cassert>
 
 #include "lockFree.h"
@@ -64,6 +65,8 @@ namespace dawn
     lockFreeStack<memoryNode_t *> memoryStoreQueue_[MAX_MULTIPLE];
     lockFreeStack<memoryNode_t *> storeEmptyLFQueue_;
     std::list<void *> allCreateMem_;
+    /// @brief Slabs of memory blocks, they are allocated following memory policy.
+    std::list<std::pair<void *, size_t>> allCreateSlab_;
   };
 
   class threadLocalMemoryPool final
@@ -84,8 +84,13 @@ namespace dawn
     {
       auto p_LF_node = new LF_node_t<FuncWrapper>(std::forward<T>(workTask));
       taskStack_.pushNode(p_LF_node);
-      should_wakeup_.store(true, std::memory_order_release);
-      taskNumber_.fetch_add(1, std::memory_order_release);
+      {
+        ///@note Worker checks the flags under queueMutex_ before it sleeps, so updating them under the
+        ///      same mutex keeps the notification from slipping in between.
+        std::lock_guard<std::mutex> stackLock(queueMutex_);
+        should_wakeup_.store(true, std::memory_order_release);
+        taskNumber_.fetch_add(1, std::memory_order_release);
+      }
       threadCond_.notify_one();
       return PROCESS_SUCCESS;
     }
@@ -2,6 +2,9 @@
 #define _QOS_CONFIG_H_
 #include <any>
 #include <shared_mutex>
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
 
 #include "transport.h"
 
@@ -13,6 +16,13 @@
 
 namespace dawn
 {
+  struct shmLoanedMsg;
+  struct shmBorrowedMsg;
+  struct shmChannel;
+
+  /// @brief Callback of batch read, data is valid only during the call.
+  using batchReadFunc = std::function<void(const void *data, uint32_t data_len)>;
+
   struct qosCfg
   {
     enum class QOS_TYPE
@@ -20,12 +30,54 @@ namespace dawn
       RELIABLE,
       EFFICIENT
     };
+
+    /// @brief What a publisher does when the oldest message isn't consumed by every reliable reader yet.
+    enum class FULL_POLICY
+    {
+      /// @brief Recycle the oldest message anyway, a slow reader loses it.
+      DROP_OLDEST,
+      /// @brief Wait for the slowest reader up to fullTimeoutUs_, then fail the publish.
+      BLOCK,
+      /// @brief Evict the slowest reader, it restarts from the oldest alive message.
+      ///        A reader still registering can't be evicted, it is waited for like BLOCK.
+      EVICT_SLOWEST
+    };
+
+    /// @brief Geometry of one size class pool of a topic.
+    struct shmPoolCfg
+    {
+      /// @brief Content size of a block, it must be a multiple of 8.
+      uint32_t  blockContentSize_;
+      uint32_t  blockNum_;
+    };
+
     qosCfg() = default;
     explicit qosCfg(QOS_TYPE qos_type) :
       qosType_(qos_type)
     {}
     virtual ~qosCfg() = default;
     QOS_TYPE qosType_ = QOS_TYPE::EFFICIENT;
+    /// @brief Size class pools owned by topic. Topic shares the global pool if it is empty.
+    ///        Publishers and subscribers of a topic must use the same pools.
+    std::vector<shmPoolCfg> shmPoolCfgVec_;
+    /// @brief Depth of topic ring buffer, it must be a power of two. 0 means SHM_RING_BUFFER_DEPTH.
+    /// @note Ring depth and pool block number take effect only in the process which creates topic,
+    ///       other processes attach with the geometry written in share memory.
+    uint32_t ringDepth_ = 0;
+    /// @brief Blocking type of read and borrow which don't pass one.
+    abstractTransport::BLOCKING_TYPE blockType_ = abstractTransport::BLOCKING_TYPE::BLOCK;
+    /// @brief How long ADAPTIVE reader spins before parking.
+    uint32_t spinBudgetUs_ = 50;
+    FULL_POLICY fullPolicy_ = FULL_POLICY::DROP_OLDEST;
+    /// @brief How long BLOCK policy waits for the slowest reader.
+    uint32_t fullTimeoutUs_ = 1000;
+    /// @brief How long a publisher waits for blocks freed by readers when pools are full, 0 fails at once.
+    uint32_t allocTimeoutUs_ = 0;
+    /// @brief Background reclaimer retires messages older than it, 0 disables it.
+    uint32_t lifespanUs_ = 0;
+    /// @brief Background reclaimer keeps at most so many messages in ring buffer, 0 disables it.
+    /// @note Reclaimer never retires a message which a reliable reader hasn't consumed unless full policy is DROP_OLDEST.
+    uint32_t historyDepth_ = 0;
   };
 
   struct reliableQosCfg : public qosCfg
@@ -50,11 +102,26 @@ namespace dawn
 
     virtual bool write(const void *write_data, const uint32_t data_len) = 0;
 
+    virtual bool write(const iovec *iov, int iovcnt) = 0;
+
+    virtual bool writeBatch(const iovec *msgs, uint32_t msgNum) = 0;
+
+    virtual bool loan(const uint32_t data_len, shmLoanedMsg &loanedMsg) = 0;
+
+    virtual bool publish(shmLoanedMsg &loanedMsg) = 0;
+
     virtual bool read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type) = 0;
 
+    virtual bool borrow(shmBorrowedMsg &borrowedMsg, abstractTransport::BLOCKING_TYPE block_type) = 0;
+
+    virtual bool readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, abstractTransport::BLOCKING_TYPE block_type) = 0;
+
     /// @brief Get QoS type from config.
     /// @return 
     virtual qosCfg::QOS_TYPE getQosType() = 0;
+
+    /// @brief Channel which publishers of topic notify.
+    virtual std::shared_ptr<shmChannel> getChannel() = 0;
   };
 } //namespace dawn
 
@@ -0,0 +1,61 @@
+#ifndef _SHM_EVENT_BRIDGE_H_
+#define _SHM_EVENT_BRIDGE_H_
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shmTransport.h"
+
+namespace dawn
+{
+  /// @brief Bridge re-reads its registry at least once per refresh period.
+  constexpr const uint32_t SHM_EVENT_BRIDGE_REFRESH_MS = 100;
+
+  /// @brief Turn topic notifications into eventfd events, so shm topics share an epoll loop with sockets.
+  ///        Property: thread safe.
+  /// @note Publishers in other processes can't signal an eventfd of this process without passing the fd,
+  ///       so one bridge thread per process parks on notify words of registered topics and signals their eventfds.
+  ///       Publishers keep their single futex notification and don't know about eventfds.
+  struct shmEventBridge
+  {
+    /// @brief Bridge shared by transports of this process, it runs while anyone holds it.
+    static std::shared_ptr<shmEventBridge> getEventBridge();
+
+    shmEventBridge();
+    ~shmEventBridge();
+    shmEventBridge(const shmEventBridge&) = delete;
+    shmEventBridge& operator=(const shmEventBridge&) = delete;
+
+    /// @brief Signal eventFd whenever channel is notified, eventFd is signaled once at once for pending messages.
+    /// @return PROCESS_FAIL if bridge already watches SHM_WAIT_CHANNEL_MAX_NUM - 1 topics.
+    bool registerEventFd(int eventFd, std::shared_ptr<shmChannel> channel_ptr);
+
+    /// @brief Stop signaling eventFd, it can be closed after return.
+    /// @return PROCESS_FAIL if eventFd is not registered.
+    bool unregisterEventFd(int eventFd);
+
+    protected:
+    struct notifierType
+    {
+      int                           eventFd_;
+      std::shared_ptr<shmChannel>   channel_ptr_;
+      /// @brief Notify sequence when eventFd was signaled last time.
+      uint32_t                      seenSequence_;
+    };
+
+    void bridgeRun();
+    static void signalEventFd(int eventFd);
+
+    std::mutex                    mutex_;
+    std::vector<notifierType>     notifierVec_;
+    std::atomic<bool>             runFlag_{true};
+    /// @brief Private wakeup word, registry changes wake the bridge thread through it.
+    shmChannel::IPC_t             wakeupIpc_;
+    shmChannel                    wakeupChannel_;
+    std::unique_ptr<std::thread>  thread_;
+  };
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef _SHM_LISTENER_H_
+#define _SHM_LISTENER_H_
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shmTransport.h"
+#include "common/threadPool.h"
+
+namespace dawn
+{
+  /// @brief Listener picks up subscription changes at least once per refresh period.
+  constexpr const uint32_t SHM_LISTENER_REFRESH_MS = 10;
+  /// @brief Most messages one dispatch task reads before it yields executor to other topics.
+  constexpr const uint32_t SHM_LISTENER_DRAIN_NUM = 64;
+
+  /// @brief Deliver messages of many topics to callbacks on executors, subscribers need no reading thread.
+  ///        Property: thread safe.
+  /// @note A few listener threads park on the notify words of all their topics at once. A ready topic is
+  ///       drained by a task pushed to the executor of its subscription. Every subscription has at most one
+  ///       task in flight, so its callback never runs concurrently and messages of a topic keep their order.
+  struct shmListener
+  {
+    /// @param listenerNum number of listener threads, each one watches up to SHM_WAIT_CHANNEL_MAX_NUM topics.
+    shmListener(uint32_t listenerNum = 1);
+    ~shmListener();
+    shmListener(const shmListener&) = delete;
+    shmListener& operator=(const shmListener&) = delete;
+
+    /// @brief Call callback on executor with every message of topic.
+    /// @param topic
+    /// @param callback data is valid only during the call.
+    /// @param executor thread pool running callback.
+    /// @param qosCfg_ptr QoS of the transport reading topic.
+    /// @return subscription id, SHM_INVALID_INDEX if every listener is full.
+    uint32_t subscribe(std::string_view topic, const batchReadFunc &callback, std::shared_ptr<threadPool> executor, \
+      std::shared_ptr<qosCfg> qosCfg_ptr = std::make_shared<qosCfg>());
+
+    /// @brief Cancel subscription, it returns after the running callback of subscription finishes.
+    /// @note Don't call it from callback of the same subscription.
+    /// @return PROCESS_FAIL if subscription is not found.
+    bool unsubscribe(uint32_t subscriptionId);
+
+    /// @brief Stop listener threads, subscriptions are not dispatched any more.
+    void stop();
+
+    protected:
+    struct subscriptionType
+    {
+      uint32_t                        id_;
+      std::shared_ptr<shmTransport>   transport_ptr_;
+      std::shared_ptr<shmChannel>     channel_ptr_;
+      batchReadFunc                   callback_;
+      std::shared_ptr<threadPool>     executor_ptr_;
+      /// @brief A task of subscription is queued or running.
+      std::atomic<bool>               dispatching_{false};
+      std::atomic<bool>               cancelled_{false};
+      /// @brief Notify sequence the last dispatch started from.
+      std::atomic<uint32_t>           seenSequence_{0};
+    };
+
+    struct listenerType
+    {
+      std::mutex                                      mutex_;
+      std::vector<std::shared_ptr<subscriptionType>>  subscriptionVec_;
+      std::atomic<bool>                               changed_{false};
+      std::unique_ptr<std::thread>                    thread_;
+    };
+
+    void listenerRun(listenerType &listener);
+    static void dispatch(const std::shared_ptr<subscriptionType> &subscription_ptr);
+    static void drain(const std::shared_ptr<subscriptionType> &subscription_ptr);
+
+    std::vector<std::unique_ptr<listenerType>>  listenerVec_;
+    std::atomic<bool>                           runFlag_{true};
+    std::atomic<uint32_t>                       nextSubscriptionId_{0};
+  };
+}
+
+#endif
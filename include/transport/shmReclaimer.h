@@ -0,0 +1,48 @@
+#ifndef _SHM_RECLAIMER_H_
+#define _SHM_RECLAIMER_H_
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dawn
+{
+  struct shmTransportImpl;
+
+  /// @brief Reclaimer visits registered topics once per period.
+  constexpr const uint32_t SHM_RECLAIM_PERIOD_US = 1000;
+  /// @brief Most messages retired from one topic per visit, so a busy topic doesn't starve others.
+  constexpr const uint32_t SHM_RECLAIM_BATCH_NUM = 1024;
+
+  /// @brief Retire messages past lifespan or history depth of topics in the background,
+  ///        so publishers seldom find ring buffer or pools full and recycle inline.
+  ///        Property: thread safe.
+  /// @note Reclaimer sleeps between visits instead of parking on notify words of topics,
+  ///       otherwise every publish would pay a futex wake for it.
+  struct shmReclaimer
+  {
+    /// @brief Reclaimer shared by transports of this process, it runs while anyone holds it.
+    static std::shared_ptr<shmReclaimer> getReclaimer();
+
+    shmReclaimer();
+    ~shmReclaimer();
+    shmReclaimer(const shmReclaimer&) = delete;
+    shmReclaimer& operator=(const shmReclaimer&) = delete;
+
+    void registerTopic(shmTransportImpl *impl_raw_ptr);
+
+    /// @brief Stop visiting topic, it can be destroyed after return.
+    void unregisterTopic(shmTransportImpl *impl_raw_ptr);
+
+    protected:
+    void reclaimRun();
+
+    std::mutex                      mutex_;
+    std::vector<shmTransportImpl*>  topicVec_;
+    std::atomic<bool>               runFlag_{true};
+    std::unique_ptr<std::thread>    thread_;
+  };
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef _SHM_TOPIC_H_
+#define _SHM_TOPIC_H_
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "shmTransport.h"
+
+namespace dawn
+{
+  /// @brief Content of a block starts after its 8 byte head and blocks are multiples of 8 bytes.
+  constexpr const uint32_t SHM_BLOCK_CONTENT_ALIGN = 8;
+
+  /// @brief The smallest size class whose one block holds size, SHM_INVALID_INDEX if no size class does.
+  constexpr uint32_t getShmSizeClass(size_t size)
+  {
+    for (auto sizeClass : {SHM_SIZE_CLASS_64B, SHM_SIZE_CLASS_256B, SHM_SIZE_CLASS_1K, SHM_SIZE_CLASS_16K, SHM_SIZE_CLASS_256K})
+    {
+      if (size <= sizeClass)
+      {
+        return sizeClass;
+      }
+    }
+    return SHM_INVALID_INDEX;
+  }
+
+  /// @brief Compile time traits of a typed topic.
+  template<typename T>
+  struct shmTopicTraits
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "message of typed topic must be trivially copyable");
+    static_assert(alignof(T) <= SHM_BLOCK_CONTENT_ALIGN, "message of typed topic is over aligned for shm block");
+    static_assert(sizeof(T) <= UINT32_MAX, "message of typed topic is too large");
+
+    /// @brief Message fits one block, so it is always one contiguous piece of shm.
+    static constexpr bool SINGLE_BLOCK = (getShmSizeClass(sizeof(T)) != SHM_INVALID_INDEX);
+    /// @brief Block size of the pool a typed topic creates.
+    static constexpr uint32_t SIZE_CLASS = SINGLE_BLOCK ? getShmSizeClass(sizeof(T)) : SHM_SIZE_CLASS_256K;
+
+    /// @brief Make a message from args, aggregates are initialized by braces.
+    template<typename... Args>
+    static T makeMsg(Args&&... args)
+    {
+      if constexpr (std::is_constructible_v<T, Args&&...>)
+      {
+        return T(std::forward<Args>(args)...);
+      }
+      else
+      {
+        return T{std::forward<Args>(args)...};
+      }
+    }
+
+    /// @brief Give topic a pool of SIZE_CLASS unless pools are configured, pool holds about a ring of messages
+    ///        within SHM_TOTAL_CONTENT_SIZE.
+    static std::shared_ptr<qosCfg> makeQosCfg(std::shared_ptr<qosCfg> qosCfg_ptr)
+    {
+      auto cfg_ptr = std::make_shared<qosCfg>(*qosCfg_ptr);
+      if (cfg_ptr->shmPoolCfgVec_.empty())
+      {
+        uint32_t ringDepth = (cfg_ptr->ringDepth_ == 0) ? SHM_RING_BUFFER_DEPTH : cfg_ptr->ringDepth_;
+        uint32_t blockNum = std::max(1U, std::min(ringDepth, SHM_TOTAL_CONTENT_SIZE / SIZE_CLASS));
+        cfg_ptr->shmPoolCfgVec_.emplace_back(qosCfg::shmPoolCfg{SIZE_CLASS, blockNum});
+      }
+      return cfg_ptr;
+    }
+  };
+
+  /// @brief Publisher of a topic carrying trivially copyable T.
+  ///        Message is constructed straight in a loaned shm block.
+  ///        Property: thread safe.
+  /// @note Topic created by a typed endpoint owns a pool whose one block holds T. If topic was created with
+  ///       other pools and a message of single block type is split, publish fails.
+  template<typename T>
+  struct shmPublisher
+  {
+    using traits = shmTopicTraits<T>;
+
+    shmPublisher(std::string_view identity, std::shared_ptr<qosCfg> qosCfg_ptr = std::make_shared<qosCfg>()):
+      transport_(identity, traits::makeQosCfg(qosCfg_ptr))
+    {
+    }
+    ~shmPublisher() = default;
+
+    /// @brief Construct a message in shm from args and publish it.
+    /// @return PROCESS_SUCCESS: publish successfully. Otherwise, shm is not enough or publish fail.
+    template<typename... Args>
+    bool publish(Args&&... args)
+    {
+      shmLoanedMsg loanedMsg;
+      if (transport_.loan(sizeof(T), loanedMsg) == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
+      if constexpr (traits::SINGLE_BLOCK)
+      {
+        auto content = loanedMsg.data();
+        if (content == nullptr)
+        {
+          LOG_ERROR("typed message of {} bytes is split by pools of topic", sizeof(T));
+          return PROCESS_FAIL;
+        }
+        new(content) T(traits::makeMsg(std::forward<Args>(args)...));
+      }
+      else
+      {
+        auto msg = traits::makeMsg(std::forward<Args>(args)...);
+        auto msgAddr = reinterpret_cast<const char*>(&msg);
+        for (auto &fragment : loanedMsg.fragments())
+        {
+          std::memcpy(fragment.iov_base, msgAddr, fragment.iov_len);
+          msgAddr += fragment.iov_len;
+        }
+      }
+      return transport_.publish(loanedMsg);
+    }
+
+    shmTransport& getTransport()
+    {
+      return transport_;
+    }
+
+    protected:
+    shmTransport      transport_;
+  };
+
+  /// @brief Subscriber of a topic carrying trivially copyable T.
+  ///        Taken message stays pinned in shm until next take or release, so reading it costs no copy.
+  ///        Property: non thread safe.
+  template<typename T>
+  struct shmSubscriber
+  {
+    using traits = shmTopicTraits<T>;
+
+    shmSubscriber(std::string_view identity, std::shared_ptr<qosCfg> qosCfg_ptr = std::make_shared<qosCfg>()):
+      transport_(identity, traits::makeQosCfg(qosCfg_ptr))
+    {
+    }
+    ~shmSubscriber() = default;
+
+    /// @brief Take the next message as qosCfg::blockType_ and release the previous one.
+    /// @return PROCESS_SUCCESS: a message is taken, get it by get().
+    bool take()
+    {
+      return take(transport_.blockType_);
+    }
+
+    /// @brief Take the next message and release the previous one.
+    /// @param block_type blocking or non-blocking
+    /// @return PROCESS_SUCCESS: a message is taken, get it by get().
+    bool take(abstractTransport::BLOCKING_TYPE block_type)
+    {
+      release();
+      if (transport_.borrow(borrowedMsg_, block_type) == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
+      if (borrowedMsg_.size() != sizeof(T))
+      {
+        LOG_ERROR("typed subscriber of {} bytes takes a message of {} bytes", sizeof(T), borrowedMsg_.size());
+        release();
+        return PROCESS_FAIL;
+      }
+      if constexpr (traits::SINGLE_BLOCK)
+      {
+        msg_ptr_ = reinterpret_cast<const T*>(borrowedMsg_.data());
+        if (msg_ptr_ == nullptr)
+        {
+          LOG_ERROR("typed message of {} bytes is split by pools of topic", sizeof(T));
+          release();
+          return PROCESS_FAIL;
+        }
+      }
+      else
+      {
+        auto msgAddr = reinterpret_cast<char*>(&msgStorage_);
+        for (auto &fragment : borrowedMsg_.fragments())
+        {
+          std::memcpy(msgAddr, fragment.iov_base, fragment.iov_len);
+          msgAddr += fragment.iov_len;
+        }
+        msg_ptr_ = reinterpret_cast<const T*>(&msgStorage_);
+      }
+      return PROCESS_SUCCESS;
+    }
+
+    /// @brief The taken message, it is valid until next take or release.
+    const T& get() const
+    {
+      assert(msg_ptr_ != nullptr && "no typed message is taken");
+      return *msg_ptr_;
+    }
+
+    /// @brief Unpin the taken message.
+    void release()
+    {
+      msg_ptr_ = nullptr;
+      borrowedMsg_.release();
+    }
+
+    shmTransport& getTransport()
+    {
+      return transport_;
+    }
+
+    protected:
+    shmTransport      transport_;
+    shmBorrowedMsg    borrowedMsg_;
+    const T           *msg_ptr_ = nullptr;
+    /// @brief Copy of a message which spans more than one block.
+    std::conditional_t<traits::SINGLE_BLOCK, char, std::aligned_storage_t<sizeof(T), alignof(T)>>  msgStorage_;
+  };
+
+  /// @brief Latest value topic carrying trivially copyable T, see shmLatestTopic.
+  ///        Property: thread safe.
+  template<typename T>
+  struct shmLatestValue
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "latest value must be trivially copyable");
+    static_assert(sizeof(T) <= UINT32_MAX, "latest value is too large");
+
+    /// @throw std::runtime_error if topic is created with a capacity other than sizeof(T).
+    shmLatestValue(std::string_view identity):
+      topic_(identity, sizeof(T))
+    {
+      //Values are copied straight into T, a topic created for another size could overrun it.
+      if (topic_.getCapacity() != sizeof(T))
+      {
+        throw std::runtime_error("dawn: latest value topic is created for another size");
+      }
+    }
+    ~shmLatestValue() = default;
+
+    bool write(const T &value)
+    {
+      return topic_.write(&value, sizeof(T));
+    }
+
+    /// @brief Copy value if it is newer than the last one read through this handle.
+    bool read(T &value, abstractTransport::BLOCKING_TYPE block_type = abstractTransport::BLOCKING_TYPE::NON_BLOCK)
+    {
+      uint32_t len = 0;
+      return (topic_.read(&value, len, block_type) == PROCESS_SUCCESS && len == sizeof(T)) ? PROCESS_SUCCESS : PROCESS_FAIL;
+    }
+
+    /// @brief Copy latest value whether it was read or not.
+    bool readLatest(T &value, uint64_t *timeStamp = nullptr)
+    {
+      uint32_t len = 0;
+      return (topic_.readLatest(&value, len, timeStamp) == PROCESS_SUCCESS && len == sizeof(T)) ? PROCESS_SUCCESS : PROCESS_FAIL;
+    }
+
+    shmLatestTopic& getTopic()
+    {
+      return topic_;
+    }
+
+    protected:
+    shmLatestTopic    topic_;
+  };
+}
+
+#endif
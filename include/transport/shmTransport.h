@@ -2,6 +2,10 @@
 #define _SHM_TRANSPORT_H_
 #include <set>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <sys/uio.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/interprocess/shared_memory_object.hpp>
@@ -16,7 +20,6 @@
 #include <boost/interprocess/sync/named_mutex.hpp>
 #include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
 #include <boost/interprocess/sync/named_semaphore.hpp>
-#include <boost/interprocess/ipc/message_queue.hpp>
 
 #include "transport.h"
 #include "common/setLogger.h"
@@ -24,27 +27,73 @@
 
 namespace dawn
 {
-  /// @brief shm ring buffer block content: |shm_message_index, message_size, time stamp|...|...|...
-  ///        each size of block is 12 byte.
-  constexpr const uint8_t SHM_INDEX_BLOCK_SIZE = 4 * 3;
-  constexpr const uint8_t SHM_INDEX_RING_BUFFER_HEAD_SIZE = 4 * 3;
+  constexpr const uint32_t SHM_CACHE_LINE_SIZE = 64;
+  /// @brief shm ring buffer block content: |sequence, time stamp, shm_message_index, message_size, pool index, reserved|...|...|...
+  ///        each size of block is 32 byte.
+  constexpr const uint32_t SHM_INDEX_BLOCK_SIZE = 8 * 2 + 4 * 4;
+  /// @brief Most reliable readers whose cursors are registered in a ring buffer.
+  constexpr const uint32_t SHM_READER_MAX_NUM = 64;
+  /// @brief ring buffer head: |geometry|start index|claim index|end index|reader cursors...|,
+  ///        each one owns a cache line.
+  constexpr const uint32_t SHM_INDEX_RING_BUFFER_HEAD_SIZE = SHM_CACHE_LINE_SIZE * (4 + SHM_READER_MAX_NUM);
+  /// @brief Default depth of ring buffer, depth must be a power of two.
+  constexpr const uint32_t SHM_RING_BUFFER_DEPTH = 1024 * 8;
   constexpr const uint32_t SHM_BLOCK_NUM = 1024 * 10;
-  /// @brief BLOCK content: |next, message|...|...
-  constexpr const uint32_t SHM_BLOCK_HEAD_SIZE = 4;
+  /// @brief BLOCK content: |next, block number, message|...|...
+  ///        Message of an extent runs over the heads of the following adjacent blocks.
+  constexpr const uint32_t SHM_BLOCK_HEAD_SIZE = 4 * 2;
+  /// @brief Block content size of the global pool shared by topics without their own pools.
   constexpr const uint32_t SHM_BLOCK_CONTENT_SIZE = 1024;
   constexpr const uint32_t SHM_BLOCK_SIZE = SHM_BLOCK_CONTENT_SIZE + SHM_BLOCK_HEAD_SIZE;
-  /// @brief total sum of content size is 10M byte.
+  /// @brief Byte filled into recycled blocks when DAWN_SHM_DEBUG_SCRUB is defined.
+  constexpr const uint8_t  SHM_DEBUG_SCRUB_BYTE = 0xdd;
+  /// @brief total sum of content size of the global pool is 10M byte.
   constexpr const uint32_t SHM_TOTAL_CONTENT_SIZE = SHM_BLOCK_CONTENT_SIZE * SHM_BLOCK_NUM;
   constexpr const uint32_t SHM_TOTAL_SIZE = SHM_BLOCK_NUM * SHM_BLOCK_SIZE;
-  constexpr const uint32_t SHM_RING_BUFFER_SIZE = SHM_INDEX_BLOCK_SIZE * SHM_BLOCK_NUM + SHM_INDEX_RING_BUFFER_HEAD_SIZE;
+  /// @brief Block content size of size class pools, which can be chosen by topic through qosCfg.
+  constexpr const uint32_t SHM_SIZE_CLASS_64B = 64;
+  constexpr const uint32_t SHM_SIZE_CLASS_256B = 256;
+  constexpr const uint32_t SHM_SIZE_CLASS_1K = 1024;
+  constexpr const uint32_t SHM_SIZE_CLASS_16K = 16 * 1024;
+  constexpr const uint32_t SHM_SIZE_CLASS_256K = 256 * 1024;
+  /// @brief Creator stores it to segment head after geometry is written, attachers wait for it.
+  constexpr const uint32_t SHM_SEGMENT_READY_FLAG = 0x6461776e;
+  constexpr const uint32_t SHM_SEGMENT_ATTACH_TIMEOUT_MS = 1000;
+  /// @brief How long a publisher waits for an earlier claimed slot before it gives the claim up.
+  constexpr const uint32_t SHM_RING_COMMIT_TIMEOUT_US = 100 * 1000;
+  /// @brief Layout version of topic segment, attachers refuse a segment of another version.
+  ///        Bump it whenever layout or meaning of any part of the segment changes.
+  ///        1: first versioned layout. 2: pools hold a free channel. 3: ring slots carry writing and abandoned flags.
+  ///        4: pool bitmap bit set means used, pool heads carry a version. 5: pool heads count space waiters.
+  constexpr const uint32_t SHM_TOPIC_SEGMENT_VERSION = 5;
+  /// @brief Layout version of message pool head. Topic pools are guarded by topic version too, so it matters
+  ///        for standalone pools like the global pool, which outlive the build that created them.
+  ///        1: bitmap bit set means used, head holds a free channel. 2: head counts space waiters.
+  constexpr const uint32_t SHM_POOL_SEGMENT_VERSION = 2;
+  /// @brief Layout version of latest value segment.
+  ///        1: first versioned layout. 2: slot records the process of its writer.
+  constexpr const uint32_t SHM_LATEST_SEGMENT_VERSION = 2;
+  /// @brief Layout version of keyed topic segment.
+  ///        1: first versioned layout. 2: slot records the process of its writer.
+  constexpr const uint32_t SHM_KEYED_SEGMENT_VERSION = 2;
+  /// @brief Most size class pools held in a topic segment.
+  constexpr const uint32_t SHM_TOPIC_POOL_MAX_NUM = 8;
+  /// @brief Spinning reader retries ring buffer at least once per SHM_SPIN_RETRY_NUM spins.
+  constexpr const uint32_t SHM_SPIN_RETRY_NUM = 256;
+  constexpr const uint32_t SHM_SPIN_BUDGET_US = 50;
+  /// @brief Reader gives up a seqlock slot after so many retries, a writer which died mid-write leaves it odd.
+  constexpr const uint32_t SHM_SEQLOCK_RETRY_NUM = 4096;
+  /// @brief Most channels parked on at once, it is FUTEX_WAITV_MAX of kernel.
+  constexpr const uint32_t SHM_WAIT_CHANNEL_MAX_NUM = 128;
   constexpr const uint32_t SHM_INVALID_INDEX = 0xffffffff;
+  constexpr const uint64_t SHM_INVALID_SEQUENCE = 0xffffffffffffffff;
   constexpr const char*   SHM_MSG_IDENTITY = "dawn_msg";
-  constexpr const char*   RING_BUFFER_PREFIX = "ring.";
-  constexpr const char*   CHANNEL_PREFIX = "ch.";
-  constexpr const char*   MESSAGE_QUEUE_PREFIX = "mq.";
+  constexpr const char*   TOPIC_PREFIX = "topic.";
+  constexpr const char*   LATEST_PREFIX = "latest.";
+  constexpr const char*   KEYED_PREFIX = "keyed.";
   constexpr const char*   MECHANISM_PREFIX = "msm.";
 
-#define FIND_SHARE_MEM_BLOCK_ADDR(head, index)  (((char*)head) + (index * SHM_BLOCK_SIZE))
+#define FIND_SHARE_MEM_BLOCK_ADDR(head, index, blockSize)  (((char*)head) + (static_cast<uint64_t>(index) * (blockSize)))
 #define FIND_NEXT_MESSAGE_BLOCK_ADDR(head, index)   (((char*)head) + (reinterpret_cast<msgType*>((char*)head) + (index * SHM_BLOCK_SIZE)->next_))
 
   struct shmTransport;
@@ -103,16 +152,34 @@ namespace dawn
     new(mechanism_raw_ptr_)  T;
   }
 
+  struct shmEventBridge;
+
+  /// @brief Notification channel of a topic built on a futex word in share memory.
+  /// @note Publishers bump the notify sequence and issue FUTEX_WAKE only when a subscriber is parked,
+  ///       so a publish without sleeping subscribers costs no syscall.
+  ///       Waiters with a condition re-check it after every wakeup and park again if it doesn't hold,
+  ///       so a subscriber returns only when its own cursor is behind.
   struct shmChannel
   {
     struct IPC_t
     {
-      BI::interprocess_condition           condition_;
-      BI::interprocess_mutex             mutex_;
+      /// @brief Futex word, it is bumped by every notification.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>   notifySequence_{0};
+      /// @brief Number of parked subscribers.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>   waiterNum_{0};
     };
 
     shmChannel() = default;
     shmChannel(std::string_view identity);
+    /// @brief Attach to a channel placed in a topic segment.
+    /// @param identity name of channel, it is only for logs.
+    /// @param region_ptr mapped topic segment, channel keeps it mapped.
+    /// @param offset offset of channel in segment.
+    shmChannel(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset);
+    /// @brief Wrap a channel living in memory owned by caller, such as a wakeup word private to a process.
+    /// @param identity name of channel, it is only for logs.
+    /// @param ipc_raw_ptr channel memory, it must outlive the channel.
+    shmChannel(std::string_view identity, IPC_t *ipc_raw_ptr);
     ~shmChannel() = default;
     void initialize(std::string_view identity);
     void notifyAll();
@@ -122,29 +189,109 @@ namespace dawn
     bool tryWaitNotify(uint32_t microseconds = 1);
     template<typename FUNC_T>
     bool tryWaitNotify(FUNC_T&& func, uint32_t microsecond = 1);
+    /// @brief Current notify sequence, load it before checking a condition and park on it.
+    uint32_t getNotifySequence() const;
+    /// @brief Park until notify sequence of any channel moves away from its sequence.
+    /// @param channels channels to park on, at most SHM_WAIT_CHANNEL_MAX_NUM.
+    /// @param sequences notify sequence of each channel loaded before the caller checked its condition.
+    /// @param channelNum
+    /// @param deadline nullptr means waiting forever.
+    /// @return PROCESS_FAIL if deadline passed. Wakeup may be spurious, so caller checks its conditions again.
+    static bool parkWaitAny(shmChannel *const *channels, const uint32_t *sequences, uint32_t channelNum, \
+      const std::chrono::steady_clock::time_point *deadline);
     protected:
+    /// @brief Park until notify sequence moves away from sequence.
+    /// @param sequence notify sequence loaded before the caller checked its condition.
+    /// @param deadline nullptr means waiting forever.
+    /// @return PROCESS_FAIL if deadline passed.
+    bool parkWait(uint32_t sequence, const std::chrono::steady_clock::time_point *deadline);
+
     std::string                                 identity_;
     std::shared_ptr<interprocessMechanism<IPC_t>> ipc_ptr_;
+    std::shared_ptr<BI::mapped_region>          channelShmRegion_ptr_;
+    IPC_t                                       *channel_raw_ptr_ = nullptr;
   };
 
   /// @brief Using share memory to deliver message,
   ///    because of thinking about the scenario for one publisher to multiple subscribers.
+  /// @note Every published index block gets a monotonically increasing 64-bit sequence number,
+  ///       which is also the ring buffer index passed through this interface.
+  ///       Publishers claim a sequence by CAS, fill the slot and stamp its sequence word.
+  ///       End index only passes stamped slots. Any publisher moves it over slots stamped by others,
+  ///       so commit order doesn't wait for the slowest publisher once its slot is filled.
+  ///       Readers copy a slot and validate its sequence word seqlock-style, so they never block publishers.
+  /// @note A publisher which stalls between claim and stamp, or dies there, holds end index back for
+  ///       SHM_RING_COMMIT_TIMEOUT_US. Then the next publisher abandons the stalled slot, readers skip it and
+  ///       the stalled publisher fails when it wakes. A publisher stalled inside the slot copy longer than
+  ///       the whole ring takes to wrap can still tear the slot of a later sequence.
   struct shmIndexRingBuffer
   {
     friend struct shmTransport;
-    struct ringBufferIndexBlockType
+    /// @note Sequence and timestamp form an aligned 16-byte pair, comparing sequences tells new data and gaps.
+    struct alignas(16) ringBufferIndexBlockType
     {
+      /// @brief Sequence of message in ring buffer, it is assigned when message is published.
+      uint64_t      sequence_;
+      /// @brief Nanosecond timestamp when message is published.
+      uint64_t      timeStamp_;
       uint32_t      shmMsgIndex_;
       uint32_t      msgSize_;
-      uint32_t      timeStamp_;
+      /// @brief Which pool of topic's pool set holds the message.
+      uint32_t      poolIndex_;
+      uint32_t      reserved_;
+    };
+
+    /// @brief Slot mirrors ringBufferIndexBlockType, but its sequence word is the seqlock word.
+    struct alignas(16) ringBufferSlotType
+    {
+      /// @brief Seqlock word. It is sequence + 1 when slot is published, or'ed with SLOT_WRITING_FLAG
+      ///        while its publisher writes it, or'ed with SLOT_ABANDONED_FLAG when its claim is given up.
+      std::atomic<uint64_t>         sequence_;
+      /// @brief Fields of ringBufferIndexBlockType after sequence.
+      char                          content_[sizeof(ringBufferIndexBlockType) - sizeof(uint64_t)];
+    };
+
+    static constexpr uint64_t SLOT_WRITING_FLAG = 1ULL << 62;
+    static constexpr uint64_t SLOT_ABANDONED_FLAG = 1ULL << 63;
+    static constexpr uint64_t SLOT_FLAG_MASK = SLOT_WRITING_FLAG | SLOT_ABANDONED_FLAG;
+
+    enum READER_STATE : uint32_t
+    {
+      READER_FREE = 0,
+      /// @brief Reader is filling its cursor.
+      READER_BUSY,
+      READER_ACTIVE,
+      /// @brief Publisher gave up waiting for reader, reader has to restart from start index.
+      READER_EVICTED
+    };
+
+    /// @brief Cursor of a reliable reader, publishers never recycle a message at or after it.
+    struct readerCursorType
+    {
+      /// @brief Next sequence the reader will consume.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint64_t> cursor_;
+      std::atomic<uint32_t>                 state_;
+      /// @brief Process of reader, cursor of a dead process is released by publishers.
+      ///        It is 0 while slot is free, so a busy slot never shows the process of its former owner.
+      std::atomic<uint32_t>                 pid_;
     };
-    //create a ipc mechanism to protect ring buffer
-    struct __attribute__((packed)) ringBufferType
+
+    struct ringBufferType
     {
-      uint32_t startIndex_;
-      uint32_t endIndex_;
-      uint32_t totalIndex_;
-      ringBufferIndexBlockType ringBufferBlock_[0];
+      /// @brief Geometry written by the creator of ring buffer.
+      alignas(SHM_CACHE_LINE_SIZE) uint32_t totalIndex_;
+      uint32_t                              indexMask_;
+      std::atomic<uint32_t>                 segmentState_;
+      /// @brief Number of reader cursor slots ever used, publishers only scan them.
+      std::atomic<uint32_t>                 readerSlotNum_;
+      /// @brief Sequence of the oldest message still alive.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint64_t> startIndex_;
+      /// @brief Next sequence handed out to publishers.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint64_t> claimIndex_;
+      /// @brief Sequence after the latest committed message.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint64_t> endIndex_;
+      readerCursorType   readerCursor_[SHM_READER_MAX_NUM];
+      ringBufferSlotType ringBufferSlot_[0];
     };
 
     enum class PROCESS_RESULT
@@ -162,140 +309,214 @@ namespace dawn
       {
       }
       ~IPC_t() = default;
-      BI::interprocess_sharable_mutex             startIndex_mutex_;
-      BI::interprocess_sharable_mutex             endIndex_mutex_;
       BI::interprocess_semaphore         ringBufferInitializedFlag_;
     };
 
     shmIndexRingBuffer() = default;
-    shmIndexRingBuffer(std::string_view identity);
+    /// @brief Create or attach a ring buffer.
+    /// @param identity
+    /// @param ringDepth depth used only when the ring buffer is created, it must be a power of two.
+    ///                  Attachers take the depth written in the ring buffer head.
+    /// @throw std::runtime_error if depth is invalid or the creator never finishes initialization.
+    shmIndexRingBuffer(std::string_view identity, uint32_t ringDepth = SHM_RING_BUFFER_DEPTH);
+    /// @brief Create or attach a ring buffer placed in a topic segment.
+    /// @param identity name of ring buffer, it is only for logs.
+    /// @param region_ptr mapped topic segment, ring buffer keeps it mapped.
+    /// @param offset offset of ring buffer in segment.
+    /// @param ringDepth depth used only by the creator.
+    /// @param isCreator creator formats ring buffer, attachers take the depth written in the head.
+    shmIndexRingBuffer(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset, uint32_t ringDepth, bool isCreator);
     ~shmIndexRingBuffer() = default;
-    void initialize(std::string_view identity);
+    void initialize(std::string_view identity, uint32_t ringDepth = SHM_RING_BUFFER_DEPTH);
+
+    /// @brief Size of a ring buffer of ringDepth.
+    /// @throw std::runtime_error if depth is not a power of two.
+    static uint64_t calculateRingBufferSize(uint32_t ringDepth);
+
+    /// @brief Depth of ring buffer.
+    uint32_t getRingDepth() const;
 
     /// @brief Start index move a step and return content pointed by previous start index.
     /// @param prevIndex 
     /// @return PROCESS_SUCCESS success; PROCESS_FAIL failed; ring buffer block
     bool moveStartIndex(ringBufferIndexBlockType &indexBlock);
 
+    /// @brief Move start index a step only if it still equals startIndex.
+    ///        Caller which decided to retire a checked message never retires a newer one by race.
+    /// @param startIndex start index got by getStartIndex.
+    /// @param indexBlock content pointed by startIndex.
+    /// @return PROCESS_FAIL if start index moved meanwhile.
+    bool moveStartIndex(uint64_t startIndex, ringBufferIndexBlockType &indexBlock);
+
     /// @brief Move end index meaning have to append new block to ring buffer.
     /// @param indexBlock 
-    /// @return PROCESS_RESULT
-    PROCESS_RESULT moveEndIndex(ringBufferIndexBlockType &indexBlock, uint32_t &storePosition);
+    /// @param storePosition sequence assigned to the appended block.
+    /// @return PROCESS_RESULT, FAIL if claim is abandoned because publisher stalled.
+    PROCESS_RESULT moveEndIndex(ringBufferIndexBlockType &indexBlock, uint64_t &storePosition);
+
+    /// @brief Append blocks to consecutive sequences by one claim and one commit.
+    /// @param indexBlocks sequence_ of every block is set, SHM_INVALID_SEQUENCE if block isn't published.
+    /// @param blockNum it must not exceed depth of ring buffer.
+    /// @param firstPosition sequence assigned to the first block.
+    /// @return PROCESS_RESULT, BUFFER_FILL if ring buffer can not hold all blocks,
+    ///         FAIL if any block isn't published, the others of an abandoned batch stay published.
+    PROCESS_RESULT moveEndIndex(ringBufferIndexBlockType *indexBlocks, uint32_t blockNum, uint64_t &firstPosition);
 
     bool getStartBuffer(ringBufferIndexBlockType &indexBlock);
 
-    bool getStartBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index);
+    bool getStartBuffer(ringBufferIndexBlockType &indexBlock, uint64_t &index);
 
     bool getLatestBuffer(ringBufferIndexBlockType &indexBlock);
 
-    bool getLatestBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index);
+    bool getLatestBuffer(ringBufferIndexBlockType &indexBlock, uint64_t &index);
 
-    bool getSpecificIndexBuffer(uint32_t index, ringBufferIndexBlockType &indexBlock);
-
-    /// @brief Watch start index and lock start index mutex until operation finish.
-    /// @param indexBlock 
-    /// @return PROCESS_SUCCESS: lock successfully and read ring buffer in start index.
-    bool watchStartBuffer(ringBufferIndexBlockType &indexBlock);
-
-    /// @brief Watch start index and lock start index mutex until operation finish.
-    /// @param indexBlock 
-    /// @return PROCESS_SUCCESS: lock successfully and read ring buffer in start index.
-    bool watchStartBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index);
-
-    /// @brief Watch end index and lock end index mutex until watch operation asked to stop.
-    /// @param indexBlock 
-    /// @return PROCESS_SUCCESS: lock successfully and read buffer. 
-    ///         PROCESS_FAIL: buffer is empty or buffer isn't initialize and will not lock.
-    bool watchLatestBuffer(ringBufferIndexBlockType &indexBlock);
-
-    /// @brief Watch end index and lock end index mutex until watch operation asked to stop.
-    /// @param indexBlock 
-    /// @return PROCESS_SUCCESS: lock successfully and read buffer. 
-    ///         PROCESS_FAIL: buffer is empty or buffer isn't initialize and will not lock.
-    bool watchLatestBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index);
-
-    /// @brief Unlock start index mutex.
-    /// @return PROCESS_SUCCESS: unlock successfully.
-    bool stopWatchStartIndex();
-
-    /// @brief Unlock ring buffer.
-    /// @return PROCESS_SUCCESS: unlock successfully.
-    bool stopWatchLatestBuffer();
-
-    /// @brief Unlock ring buffer.
-    /// @return PROCESS_SUCCESS: unlock successfully.
-    bool stopWatchSpecificIndexBuffer();
+    bool getSpecificIndexBuffer(uint64_t index, ringBufferIndexBlockType &indexBlock);
 
     /// @brief Get start index for multi-purpose.
     /// @param storeIndex reference to store start index.
     /// @param indexBlock reference to store index block content.
     /// @return PROCESS_SUCCESS: get start index successfully.
-    bool getStartIndex(uint32_t &storeIndex, ringBufferIndexBlockType &indexBlock);
+    bool getStartIndex(uint64_t &storeIndex, ringBufferIndexBlockType &indexBlock);
 
-    /// @brief Watch specific index and lock specific index mutex until watch operation asked to stop.
-    /// @param index Pass specific index to watch.
-    /// @param indexBlock Outside buffer to store index block content.
-    /// @return PROCESS_SUCCESS: lock successfully and read buffer.
-    ///         PROCESS_FAIL: index is invalid or buffer isn't initialize and will not lock.
-    bool watchSpecificIndexBuffer(uint32_t index, ringBufferIndexBlockType &indexBlock);
+    /// @brief Sequence after the latest committed message, it moves whenever a message is published.
+    uint64_t getEndIndex();
 
-    /// @brief Exclusively lock start index mutex and end index mutex.
-    /// @return PROCESS_SUCCESS: lock successfully.
-    bool exclusiveLockBuffer();
+    /// @brief Register a reliable reader whose cursor starts at start index.
+    /// @return reader id, SHM_INVALID_INDEX if registry is full.
+    uint32_t registerReader();
 
-    /// @brief Unlock start index mutex and end index mutex.
-    /// @return PROCESS_SUCCESS: unlock successfully.
-    bool exclusiveUnlockBuffer();
+    void unregisterReader(uint32_t readerId);
 
-    /// @brief sharable lock start index mutex and end index mutex.
-    /// @return PROCESS_SUCCESS: lock successfully.
-    bool sharedLockBuffer();
+    /// @brief Publish the next sequence reader will consume.
+    void updateReaderCursor(uint32_t readerId, uint64_t cursor);
 
-    /// @brief sharable unlock start index mutex and end index mutex.
-    /// @return PROCESS_SUCCESS: unlock successfully.
-    bool sharedUnlockBuffer();
+    /// @brief Re-activate an evicted reader from start index.
+    /// @return true if reader was evicted, so it must drop its own position.
+    bool reviveReader(uint32_t readerId);
 
-    /// @brief Pass indexBlock to compare the the block pointing by start index. If they are same, start index will move.
-    /// @param indexBlock 
-    /// @return PROCESS_SUCCESS: 
-    bool compareAndMoveStartIndex(ringBufferIndexBlockType &indexBlock);
+    /// @brief The smallest cursor of active readers, slots of dead processes are released meanwhile.
+    ///        A busy reader counts as sitting at start index.
+    /// @return SHM_INVALID_SEQUENCE if no reader is active.
+    uint64_t getMinReaderCursor();
+
+    /// @brief Evict the active reader with the smallest cursor, if it still holds start index.
+    /// @return PROCESS_SUCCESS if a reader is evicted. PROCESS_FAIL if no active reader holds start index,
+    ///         for example start index is held by a busy reader.
+    bool evictSlowestReader();
 
     /// @brief Check index is valid or not.
+    ///        Calling it after reading message content tells whether the message was recycled meanwhile.
     /// @param index msg index
     /// @return 
-    bool checkIndexValid(uint32_t index);
+    bool checkIndexValid(uint64_t index);
 
     /// @brief Calculate index conformed to ring buffer size.
     /// @param ringBufferIndex 
     /// @return Calculate result.
-    uint32_t calculateIndex(uint32_t ringBufferIndex);
+    uint32_t calculateIndex(uint64_t ringBufferIndex);
 
-    /// @brief 
-    /// @param ringBufferIndex 
-    /// @return 
-    uint32_t calculateLastIndex(uint32_t ringBufferIndex);
+    protected:
+    /// @brief Map ring buffer segment, then initialize it or wait for its creator.
+    void attachRingBuffer(uint32_t ringDepth);
+
+    /// @brief Write geometry of mapped ring buffer or wait for its creator, then load the mask.
+    void formatRingBuffer(uint32_t ringDepth, bool isCreator);
+
+    /// @brief Take slot of a claimed sequence for writing.
+    /// @return PROCESS_FAIL if claim is abandoned.
+    bool claimSlot(uint64_t index);
 
+    /// @brief Stamp a written slot with its sequence.
+    /// @return PROCESS_FAIL if claim is abandoned meanwhile.
+    bool stampSlot(uint64_t index);
+
+    /// @brief Give up claim of a stalled publisher, readers skip it.
+    void abandonSlot(uint64_t index);
+
+    bool isSlotAbandoned(uint64_t index);
+
+    /// @brief Release slot of a reader whose process is dead.
+    /// @note A reader which died before storing its pid can't be told from one still registering,
+    ///       so its busy slot holds start index until publishers give up by their full timeout.
+    /// @return true if slot is released.
+    bool releaseDeadReader(uint32_t readerId);
+
+    /// @brief Move end index over stamped or abandoned slots until it reaches commitIndex.
+    ///        Slot stalled longer than SHM_RING_COMMIT_TIMEOUT_US is abandoned.
+    void commitEndIndex(uint64_t commitIndex);
+
+    /// @brief Copy index block stored in slot of index and validate it seqlock-style.
+    /// @param index 
+    /// @param indexBlock 
+    /// @return PROCESS_SUCCESS: slot still holds index and copy is consistent.
+    bool readSlot(uint64_t index, ringBufferIndexBlockType &indexBlock);
+
+    public:
     std::shared_ptr<interprocessMechanism<IPC_t>>   ipc_ptr_;
     std::shared_ptr<BI::shared_memory_object>       ringBufferShm_ptr_;
     std::shared_ptr<BI::mapped_region>              ringBufferShmRegion_ptr_;
-    BI::sharable_lock<BI::interprocess_sharable_mutex>         endIndex_shared_lock_;
-    BI::sharable_lock<BI::interprocess_sharable_mutex>         startIndex_shared_lock_;
-    BI::scoped_lock<BI::interprocess_sharable_mutex>         endIndex_exclusive_lock_;
-    BI::scoped_lock<BI::interprocess_sharable_mutex>         startIndex_exclusive_lock_;
 
     ringBufferType                                  *ringBuffer_raw_ptr_;
     std::string                                     shmIdentity_;
     std::string                                     mechanismIdentity_;
+    uint64_t                                        indexMask_;
   };
 
-  struct __attribute__((packed)) msgType
+  /// @brief Flags kept in high bits of pin count of message head block.
+  constexpr const uint32_t MSG_PIN_RETIRED_FLAG = 0x80000000;
+  constexpr const uint32_t MSG_PIN_FREED_FLAG = 0x40000000;
+  constexpr const uint32_t MSG_PIN_COUNT_MASK = 0x3fffffff;
+
+  /// @brief Head of an extent, which is a run of adjacent blocks holding one piece of message.
+  ///        A message is normally one extent, it is a chain of extents only when pool is fragmented.
+  struct msgType
   {
+    /// @brief Head block of next extent of message.
     uint32_t next_ = SHM_INVALID_INDEX;
+    /// @brief Number of adjacent blocks in this extent.
+    uint32_t blockNum_ = 1;
     char     content_[0];
   };
 
+  /// @brief Fixed size block pool in share memory.
+  ///        Segment layout: |pool head|used block bitmap|pin count of blocks|blocks|, each part starts at a cache line.
+  /// @note Used blocks are tracked by a bitmap in the pool segment, so a run of adjacent blocks can be claimed
+  ///       as one extent. A run within one bitmap word costs one CAS. A longer run starts at a word boundary
+  ///       and costs one CAS per word.
+  ///       Bit of bitmap is set when block is used, so the zero filled bitmap of a new segment is a full pool.
+  ///       Creating a pool writes no per-block state, its cost is the page faults of first use.
+  ///       Recycled blocks are not scrubbed unless DAWN_SHM_DEBUG_SCRUB is defined.
+  ///       Pin counts live beside the bitmap rather than in blocks, so a late reader never writes into message content.
+  ///       Pin count of a block is never reset by allocation, so a late reader's pin and unpin always pair up.
   struct shmMsgPool
   {
+    struct poolHeadType
+    {
+      /// @brief Geometry written by the creator of pool.
+      alignas(SHM_CACHE_LINE_SIZE) uint32_t                 blockContentSize_;
+      uint32_t                                              blockNum_;
+      std::atomic<uint32_t>                                 segmentState_;
+      uint32_t                                              version_;
+      /// @brief Publishers waiting for space, freed blocks notify free channel only while it isn't zero.
+      ///        It is written only by waiting publishers, so releases mostly read it from a clean cache line.
+      std::atomic<uint32_t>                                 spaceWaiterNum_;
+      /// @brief Bitmap word to start searching from.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>    allocHint_;
+      /// @brief Approximate number of free blocks, it is only for statistics.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>    freeBlockNum_;
+      /// @brief Notified when blocks are freed while publishers wait for space, they park on it.
+      shmChannel::IPC_t                                     freeChannel_;
+    };
+
+    enum class ALLOC_RESULT
+    {
+      SUCCESS,
+      /// @brief Pool has no free blocks for now, retry after messages are recycled.
+      NO_SPACE,
+      /// @brief Data never fits pool.
+      TOO_LARGE
+    };
+
     struct IPC_t
     {
       IPC_t():
@@ -306,24 +527,461 @@ namespace dawn
       BI::interprocess_semaphore     msgPoolInitialFlag_;
     };
 
-    shmMsgPool(std::string_view identity = SHM_MSG_IDENTITY);
+    /// @brief Offsets of |poolHeadType|bitmap|pin counts|blocks| in pool segment.
+    struct poolLayoutType
+    {
+      uint64_t bitmapOffset_;
+      uint64_t pinCountOffset_;
+      uint64_t blockOffset_;
+      uint64_t poolSize_;
+    };
+
+    /// @brief Create or attach a pool.
+    /// @param identity
+    /// @param blockContentSize content size of a block, it must be a multiple of 8.
+    /// @param blockNum
+    /// @note Geometry is used only when the pool is created. Attachers take the geometry written in the pool head.
+    /// @throw std::runtime_error if geometry is invalid or the creator never finishes initialization.
+    shmMsgPool(std::string_view identity = SHM_MSG_IDENTITY, uint32_t blockContentSize = SHM_BLOCK_CONTENT_SIZE, uint32_t blockNum = SHM_BLOCK_NUM);
+    /// @brief Create or attach a pool placed in a topic segment.
+    /// @param identity name of pool, it is only for logs.
+    /// @param region_ptr mapped topic segment, pool keeps it mapped.
+    /// @param offset offset of pool in segment.
+    /// @param poolSize bytes reserved for pool in segment.
+    /// @param blockContentSize
+    /// @param blockNum
+    /// @param isCreator creator formats pool, attachers take the geometry written in the pool head.
+    shmMsgPool(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset, uint64_t poolSize, \
+      uint32_t blockContentSize, uint32_t blockNum, bool isCreator);
     ~shmMsgPool() = default;
 
-    std::vector<uint32_t> requireMsgShm(uint32_t data_size);
+    /// @brief The global pool shared by topics without their own pools, it is mapped once per process.
+    static std::shared_ptr<shmMsgPool> getGlobalPool();
+
+    /// @brief Layout of a pool segment with the geometry.
+    /// @throw std::runtime_error if geometry is invalid.
+    static poolLayoutType calculatePoolLayout(uint32_t blockContentSize, uint32_t blockNum);
+
+    /// @brief Require extents for data_size. It is one contiguous extent unless pool is fragmented.
+    /// @param data_size
+    /// @param indexVec head blocks of extents, which are already linked by next_ in order.
+    /// @return SUCCESS, or why nothing is allocated. It never throws, so overload costs no unwinding.
+    ALLOC_RESULT requireMsgShm(uint32_t data_size, std::vector<uint32_t> &indexVec);
+
+    /// @brief Allocate a batch of messages from one run of adjacent blocks, every message gets its own extent.
+    /// @param dataSizeVec size of every message.
+    /// @return head of every message, empty if pool has no run to hold the batch.
+    std::vector<uint32_t> requireMsgShmBatch(const std::vector<uint32_t> &dataSizeVec);
     uint32_t   requireOneBlock();
+
+    /// @brief Recycle one extent.
+    /// @param index head block of extent.
     bool recycleMsgShm(uint32_t index);
+
+    /// @brief Recycle every extent of a message chain.
+    /// @param headIndex head block of message.
+    bool recycleMsgChain(uint32_t headIndex);
+
+    /// @brief Pin a message to keep it from being recycled.
+    /// @param headIndex head block of message.
+    /// @return PROCESS_FAIL if message is already retired. Caller must still check the message is alive in ring buffer.
+    bool pinMsgShm(uint32_t headIndex);
+
+    /// @brief Unpin a message. The last reader recycles a retired message.
+    /// @param headIndex head block of message.
+    void unpinMsgShm(uint32_t headIndex);
+
+    /// @brief Mark a message expired. It is recycled at once if nobody pins it, otherwise by the last unpin.
+    /// @param headIndex head block of message.
+    void retireMsgShm(uint32_t headIndex);
+
     void*     getMsgRawBuffer();
 
+    /// @brief Head of extent which starts at the block.
+    msgType*  getMsgBlock(uint32_t index);
+
+    uint32_t  getBlockContentSize() const;
+
+    uint32_t  getBlockNum() const;
+
+    /// @brief Contiguous content size of an extent.
+    uint32_t  getExtentContentSize(uint32_t blockNum) const;
+
+    /// @brief Number of free blocks in pool, it is not exact while others are requiring or recycling.
+    uint32_t  getFreeBlockNum();
+
+    /// @brief Channel notified when blocks of pool are freed while a space waiter is registered.
+    std::shared_ptr<shmChannel> getFreeChannel() const;
+
+    /// @brief Register a publisher waiting for space, so freed blocks notify free channel.
+    /// @note Register before loading free sequence and trying pool. Registration and releaseExtent both order
+    ///       themselves with seq_cst, so either the waiter sees freed blocks or the release sees the waiter.
+    void addSpaceWaiter();
+    /// @brief Unregister a publisher registered by addSpaceWaiter.
+    void removeSpaceWaiter();
+
     protected:
-    uint32_t                                    defaultPriority_;
+    /// @brief Claim a run of adjacent free blocks.
+    /// @param blockNum wanted number of blocks.
+    /// @param minBlockNum a shorter run down to it is accepted, it only works when blockNum fits one bitmap word.
+    /// @param claimedBlockNum number of claimed blocks.
+    /// @return head block of run, SHM_INVALID_INDEX if no run is found.
+    uint32_t claimExtent(uint32_t blockNum, uint32_t minBlockNum, uint32_t &claimedBlockNum);
+
+    /// @brief Give a run of adjacent blocks back to bitmap.
+    /// @param index head block of run.
+    /// @param blockNum
+    void releaseExtent(uint32_t index, uint32_t blockNum);
+
+    /// @brief Initialize head of a claimed extent.
+    msgType* initializeExtent(uint32_t index, uint32_t blockNum);
+
+    /// @brief Number of blocks needed by an extent holding data_size.
+    uint32_t calculateExtentBlockNum(uint32_t data_size) const;
+
+    /// @brief Write geometry of mapped pool and free all blocks, or wait for its creator and adopt its geometry.
+    /// @param poolSize bytes mapped for pool.
+    void formatPool(uint64_t poolSize, bool isCreator);
+
     std::shared_ptr<interprocessMechanism<IPC_t>>  ipc_ptr_;
-    std::shared_ptr<BI::message_queue>          availMsg_mq_ptr_;
     std::shared_ptr<BI::shared_memory_object>   msgBufferShm_ptr_;
     std::shared_ptr<BI::mapped_region>          msgBufferShmRegion_ptr_;
+    poolHeadType                                *poolHead_raw_ptr_;
+    std::atomic<uint64_t>                       *usedBitmap_raw_ptr_;
+    std::atomic<uint32_t>                       *pinCount_raw_ptr_;
     void                                        *msgBuffer_raw_ptr_;
+    std::shared_ptr<shmChannel>                 freeChannel_ptr_;
     std::string                                 identity_;
     std::string                                 mechanismIdentity_;
-    std::string                                 mqIdentity_;
+    uint32_t                                    blockContentSize_;
+    uint32_t                                    blockSize_;
+    uint32_t                                    blockNum_;
+    uint32_t                                    bitmapWordNum_;
+  };
+
+  /// @brief All share memory of a topic in one segment, so opening a topic costs one shm_open and one mmap.
+  ///        Segment layout: |segment head|channel|ring buffer|size class pools...|, each part starts at a cache line.
+  /// @note The process whose exclusive create succeeds is the creator. It sizes the segment, formats every part
+  ///       and stores the ready flag last. Attachers wait for the flag and take the layout from the segment head.
+  ///       Topic without size class pools shares the global pool.
+  struct shmTopicSegment
+  {
+    /// @brief Offsets of parts in topic segment. Pool i takes [poolOffset_[i], poolOffset_[i + 1]).
+    struct segmentLayoutType
+    {
+      uint64_t channelOffset_;
+      uint64_t ringBufferOffset_;
+      uint64_t poolOffset_[SHM_TOPIC_POOL_MAX_NUM + 1];
+      uint32_t poolNum_;
+      uint64_t segmentSize_;
+    };
+
+    struct segmentHeadType
+    {
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>    segmentState_;
+      uint32_t                                              version_;
+      segmentLayoutType                                     layout_;
+    };
+
+    /// @brief Create or attach segment of a topic.
+    /// @param identity topic name.
+    /// @param config ring depth and size class pools are used only when the segment is created.
+    /// @throw std::runtime_error if layout is invalid, version is mismatched or the creator never finishes initialization.
+    shmTopicSegment(std::string_view identity, const qosCfg &config = qosCfg());
+    ~shmTopicSegment() = default;
+
+    std::shared_ptr<shmChannel> getChannel() const;
+
+    std::shared_ptr<shmIndexRingBuffer> getRingBuffer() const;
+
+    /// @brief Size class pools of topic sorted by block size, empty if topic shares the global pool.
+    const std::vector<std::shared_ptr<shmMsgPool>>& getPoolVec() const;
+
+    /// @brief Layout of a topic segment.
+    /// @param ringDepth
+    /// @param shmPoolCfgVec size class pools sorted by block size.
+    /// @throw std::runtime_error if geometry is invalid or there are too many pools.
+    static segmentLayoutType calculateSegmentLayout(uint32_t ringDepth, const std::vector<qosCfg::shmPoolCfg> &shmPoolCfgVec);
+
+    /// @brief Unlink segment of a topic. Processes which mapped it keep using it, later ones create a new one.
+    ///        If topic shares the global pool, messages left in its ring are retired to that pool first.
+    ///        A message still borrowed goes back when its last reader releases it.
+    /// @param identity topic name.
+    /// @return PROCESS_FAIL if topic has no segment.
+    static bool remove(std::string_view identity);
+
+    protected:
+
+    std::string                                 identity_;
+    std::shared_ptr<BI::shared_memory_object>   segmentShm_ptr_;
+    std::shared_ptr<BI::mapped_region>          segmentShmRegion_ptr_;
+    segmentHeadType                             *segmentHead_raw_ptr_;
+    std::shared_ptr<shmChannel>                 channel_ptr_;
+    std::shared_ptr<shmIndexRingBuffer>         ringBuffer_ptr_;
+    std::vector<std::shared_ptr<shmMsgPool>>    shmPoolVec_;
+  };
+
+  /// @brief Topic which keeps only its latest value, in one seqlock slot of a segment named "latest.<topic>".
+  ///        Writers overwrite the slot in place, readers copy it and validate its sequence. There is no ring
+  ///        buffer, no pool block and no lock on the read path, so readers never slow down writers.
+  ///        Property: thread safe, writers are serialized by the sequence word.
+  /// @note Reader retries when a writer overwrites the slot during its copy, so it suits small snapshots
+  ///       like state estimates. Use shmTransport if every message matters.
+  struct shmLatestTopic
+  {
+    struct latestHeadType
+    {
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>    segmentState_;
+      uint32_t                                              version_;
+      uint32_t                                              capacity_;
+    };
+
+    struct alignas(SHM_CACHE_LINE_SIZE) latestSlotType
+    {
+      /// @brief Seqlock word. It is odd while a writer fills the slot, every value is published as an even one.
+      std::atomic<uint64_t>   sequence_;
+      uint32_t                size_;
+      /// @brief Process of the writer filling slot, 0 while sequence is even.
+      std::atomic<uint32_t>   writerPid_;
+      /// @brief Nanosecond timestamp when value is written.
+      uint64_t                timeStamp_;
+    };
+
+    /// @brief Create or attach latest value segment of a topic.
+    /// @param identity topic name.
+    /// @param capacity largest value in bytes, it is used only when the segment is created.
+    /// @throw std::runtime_error if version is mismatched or the creator never finishes initialization.
+    shmLatestTopic(std::string_view identity, uint32_t capacity);
+    ~shmLatestTopic() = default;
+
+    /// @brief Overwrite latest value and notify readers.
+    ///        Slot left odd by a dead writer is taken over after SHM_SEQLOCK_RETRY_NUM retries.
+    /// @return PROCESS_FAIL if data is larger than capacity, or slot stays being written by a live writer,
+    ///         or by one which died before recording its process.
+    bool write(const void *write_data, const uint32_t data_len);
+
+    /// @brief Copy latest value if it is newer than the last one read through this handle.
+    /// @param read_data buffer of at least getCapacity() bytes.
+    /// @param data_len length of value.
+    /// @param block_type waiting type if no newer value is written.
+    /// @return PROCESS_SUCCESS if a newer value is copied.
+    bool read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type);
+
+    /// @brief Copy latest value whether it was read or not.
+    /// @param timeStamp nanosecond timestamp of value, it may be nullptr.
+    /// @return PROCESS_FAIL if nothing is written yet.
+    bool readLatest(void *read_data, uint32_t &data_len, uint64_t *timeStamp = nullptr);
+
+    uint32_t getCapacity() const;
+
+    std::shared_ptr<shmChannel> getChannel() const;
+
+    /// @brief Unlink latest value segment of a topic, processes which mapped it keep using it.
+    /// @return PROCESS_FAIL if topic has no latest value segment.
+    static bool remove(std::string_view identity);
+
+    protected:
+    /// @brief Copy slot if its sequence differs from lastSequence.
+    /// @return sequence of copied value, 0 if nothing newer is written or slot stays being written
+    ///         for SHM_SEQLOCK_RETRY_NUM retries.
+    uint64_t copySlot(void *read_data, uint32_t &data_len, uint64_t lastSequence, uint64_t *timeStamp);
+
+    std::string                                 identity_;
+    std::shared_ptr<BI::shared_memory_object>   segmentShm_ptr_;
+    std::shared_ptr<BI::mapped_region>          segmentShmRegion_ptr_;
+    latestHeadType                              *latestHead_raw_ptr_ = nullptr;
+    latestSlotType                              *slot_raw_ptr_ = nullptr;
+    char                                        *content_raw_ptr_ = nullptr;
+    std::shared_ptr<shmChannel>                 channel_ptr_;
+    uint32_t                                    capacity_ = 0;
+    /// @brief Sequence of the last value read through this handle.
+    std::atomic<uint64_t>                       lastSequence_{0};
+  };
+
+  /// @brief Callback of keyed read, data is valid only during the call.
+  using keyedReadFunc = std::function<void(uint64_t key, const void *data, uint32_t data_len)>;
+
+  /// @brief Topic which keeps the latest value of every key, in an open addressing table of a segment named
+  ///        "keyed.<topic>". Each key owns a seqlock slot which writers overwrite, so a slow reader gets
+  ///        the newest value of every updated key instead of walking each intermediate update.
+  ///        Property: thread safe.
+  /// @note Every write takes a number from a topic wide update counter. A reader keeps the largest number it
+  ///       has seen as cursor and readDirty() returns keys updated after it, so its work is bounded by the
+  ///       number of keys. Keys are never removed, write of a new key fails once every slot is taken.
+  struct shmKeyedTopic
+  {
+    struct keyedHeadType
+    {
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint32_t>    segmentState_;
+      uint32_t                                              version_;
+      /// @brief Number of slots, a power of two.
+      uint32_t                                              slotNum_;
+      uint32_t                                              valueCapacity_;
+      uint64_t                                              slotSize_;
+      /// @brief Topic wide update counter.
+      alignas(SHM_CACHE_LINE_SIZE) std::atomic<uint64_t>    updateSequence_;
+    };
+
+    enum SLOT_STATE : uint32_t
+    {
+      SLOT_EMPTY = 0,
+      /// @brief A writer is storing key of slot.
+      SLOT_CLAIMING,
+      SLOT_USED
+    };
+
+    struct alignas(SHM_CACHE_LINE_SIZE) keyedSlotType
+    {
+      std::atomic<uint32_t>   state_;
+      uint32_t                size_;
+      uint64_t                key_;
+      /// @brief Seqlock word of value, it is odd while a writer fills the slot.
+      std::atomic<uint64_t>   sequence_;
+      /// @brief Update counter value when slot was written last time.
+      uint64_t                updateSequence_;
+      /// @brief Nanosecond timestamp when value is written.
+      uint64_t                timeStamp_;
+      /// @brief Process of the writer filling value, 0 while sequence is even.
+      std::atomic<uint32_t>   writerPid_;
+    };
+
+    /// @brief Create or attach keyed segment of a topic.
+    /// @param identity topic name.
+    /// @param maxKeyNum most keys of topic, table keeps load factor under one half.
+    /// @param valueCapacity largest value in bytes.
+    /// @note Geometry is used only when the segment is created.
+    /// @throw std::runtime_error if geometry is invalid, version is mismatched or the creator never finishes initialization.
+    shmKeyedTopic(std::string_view identity, uint32_t maxKeyNum, uint32_t valueCapacity);
+    ~shmKeyedTopic() = default;
+
+    /// @brief Overwrite value of key and notify readers.
+    ///        Slot left odd by a dead writer is taken over after SHM_SEQLOCK_RETRY_NUM retries.
+    /// @return PROCESS_FAIL if value is larger than capacity, table is full, or slot stays being written
+    ///         by a live writer or by one which died before recording its process.
+    bool write(uint64_t key, const void *write_data, const uint32_t data_len);
+
+    /// @brief Copy latest value of key.
+    /// @param read_data buffer of at least getValueCapacity() bytes.
+    /// @param timeStamp nanosecond timestamp of value, it may be nullptr.
+    /// @return PROCESS_FAIL if key is never written, or its slot stays being written by a dead writer.
+    bool read(uint64_t key, void *read_data, uint32_t &data_len, uint64_t *timeStamp = nullptr);
+
+    /// @brief Hand latest value of every key updated after cursor to callback, then move cursor.
+    /// @param callback called once per updated key, keys are in table order.
+    /// @param cursor update sequence seen by reader, start from 0.
+    /// @param block_type NON_BLOCK returns at once, other types park until a key is updated.
+    /// @return number of keys handed to callback. A slot left odd by a dead writer is skipped.
+    uint32_t readDirty(const keyedReadFunc &callback, uint64_t &cursor, \
+      abstractTransport::BLOCKING_TYPE block_type = abstractTransport::BLOCKING_TYPE::NON_BLOCK);
+
+    uint32_t getValueCapacity() const;
+
+    /// @brief Number of slots, it is maxKeyNum doubled and rounded up to a power of two to keep probes short.
+    uint32_t getSlotNum() const;
+
+    std::shared_ptr<shmChannel> getChannel() const;
+
+    /// @brief Unlink keyed segment of a topic, processes which mapped it keep using it.
+    /// @return PROCESS_FAIL if topic has no keyed segment.
+    static bool remove(std::string_view identity);
+
+    protected:
+    keyedSlotType* getSlot(uint32_t index) const;
+
+    /// @brief Find slot of key.
+    /// @param claim claim an empty slot for key if key is absent.
+    /// @return nullptr if key is absent and not claimed.
+    /// @note Slot claimed for SHM_SEQLOCK_RETRY_NUM retries is skipped, so a claimer which died never stops probes.
+    ///       If its claimer is only slow and claims the same key, that key may take two slots.
+    keyedSlotType* findSlot(uint64_t key, bool claim);
+
+    /// @brief Copy value of slot consistently.
+    /// @return update sequence of copied value, 0 if slot stays being written for SHM_SEQLOCK_RETRY_NUM retries.
+    uint64_t copySlot(keyedSlotType *slot, void *read_data, uint32_t &data_len, uint64_t *timeStamp);
+
+    uint32_t scanDirty(const keyedReadFunc &callback, uint64_t &cursor, std::vector<char> &buffer);
+
+    std::string                                 identity_;
+    std::shared_ptr<BI::shared_memory_object>   segmentShm_ptr_;
+    std::shared_ptr<BI::mapped_region>          segmentShmRegion_ptr_;
+    keyedHeadType                               *keyedHead_raw_ptr_ = nullptr;
+    char                                        *slots_raw_ptr_ = nullptr;
+    std::shared_ptr<shmChannel>                 channel_ptr_;
+    uint32_t                                    slotNum_ = 0;
+    uint32_t                                    valueCapacity_ = 0;
+    uint64_t                                    slotSize_ = 0;
+  };
+
+  /// @brief A message loaned from shm pool. Producer fills it in place and hands it back by shmTransport::publish().
+  ///        Blocks are given back to pool when it is destroyed without being published.
+  ///        Property: move only, non thread safe.
+  struct shmLoanedMsg
+  {
+    friend struct shmTransportImpl;
+    shmLoanedMsg() = default;
+    ~shmLoanedMsg();
+    shmLoanedMsg(const shmLoanedMsg&) = delete;
+    shmLoanedMsg& operator=(const shmLoanedMsg&) = delete;
+    shmLoanedMsg(shmLoanedMsg &&loanedMsg);
+    shmLoanedMsg& operator=(shmLoanedMsg &&loanedMsg);
+
+    /// @brief Whether it still owns shm blocks.
+    bool valid() const;
+
+    /// @brief Size requested by loan.
+    uint32_t size() const;
+
+    /// @brief Contiguous writable pointer.
+    /// @return nullptr if message spans more than one block, use fragments() instead.
+    void* data();
+
+    /// @brief Writable pieces of message in order, which point straight to shm blocks.
+    const std::vector<iovec>& fragments() const;
+
+    /// @brief Give blocks back to pool.
+    void release();
+
+    protected:
+    uint32_t                        size_ = 0;
+    uint32_t                        poolIndex_ = 0;
+    std::vector<uint32_t>           msgIndexVec_;
+    std::vector<iovec>              fragments_;
+    std::shared_ptr<shmMsgPool>     shmPool_ptr_;
+  };
+
+  /// @brief A read only view of a message in shm. Message is pinned and won't be recycled until the view is released.
+  ///        Property: move only, non thread safe.
+  struct shmBorrowedMsg
+  {
+    friend struct shmTransportImpl;
+    shmBorrowedMsg() = default;
+    ~shmBorrowedMsg();
+    shmBorrowedMsg(const shmBorrowedMsg&) = delete;
+    shmBorrowedMsg& operator=(const shmBorrowedMsg&) = delete;
+    shmBorrowedMsg(shmBorrowedMsg &&borrowedMsg);
+    shmBorrowedMsg& operator=(shmBorrowedMsg &&borrowedMsg);
+
+    /// @brief Whether it still pins a message.
+    bool valid() const;
+
+    /// @brief Message length.
+    uint32_t size() const;
+
+    /// @brief Contiguous read only pointer.
+    /// @return nullptr if message spans more than one block, use fragments() instead.
+    const void* data() const;
+
+    /// @brief Read only pieces of message in order, which point straight to shm blocks.
+    const std::vector<iovec>& fragments() const;
+
+    /// @brief Unpin message.
+    void release();
+
+    protected:
+    uint32_t                        size_ = 0;
+    uint32_t                        headIndex_ = SHM_INVALID_INDEX;
+    std::vector<iovec>              fragments_;
+    std::shared_ptr<shmMsgPool>     shmPool_ptr_;
   };
 
   struct shmTransport: abstractTransport
@@ -341,7 +999,30 @@ namespace dawn
     /// @return PROCESS_SUCCESS: write successfully. Otherwise, write fail.
     virtual bool write(const void *write_data, const uint32_t data_len) override;
 
-    /// @brief Read data from shared memory. It is a blocking read function.
+    /// @brief Write a message gathered from fragments, every fragment is copied straight to shared memory.
+    /// @param iov fragments of message in order.
+    /// @param iovcnt number of fragments.
+    /// @return PROCESS_SUCCESS: write successfully. Otherwise, write fail.
+    virtual bool write(const iovec *iov, int iovcnt) override;
+
+    /// @brief Write a batch of messages. They are published to consecutive sequences with one wakeup.
+    /// @param msgs every iovec is one message.
+    /// @param msgNum
+    /// @return PROCESS_SUCCESS: all messages are written. Otherwise, none of them is written.
+    bool writeBatch(const iovec *msgs, uint32_t msgNum);
+
+    /// @brief Loan a writable message straight in shared memory, so producer can build it without a staging copy.
+    /// @param data_len message length
+    /// @param loanedMsg store the loaned message.
+    /// @return PROCESS_SUCCESS: loan successfully. Otherwise, shm is not enough.
+    bool loan(const uint32_t data_len, shmLoanedMsg &loanedMsg);
+
+    /// @brief Publish a loaned message. Message content isn't copied.
+    /// @param loanedMsg message got by loan(), it is invalid after published successfully.
+    /// @return PROCESS_SUCCESS: publish successfully. Otherwise, publish fail and loanedMsg is still owned by caller.
+    bool publish(shmLoanedMsg &loanedMsg);
+
+    /// @brief Read data from shared memory. It blocks as qosCfg::blockType_.
     /// @param read_data read data buffer
     /// @param data_len read data length
     /// @return PROCESS_SUCCESS: read successfully. Otherwise, read fail.
@@ -354,32 +1035,89 @@ namespace dawn
     /// @return PROCESS_SUCCESS: read successfully. Otherwise, read fail.
     virtual bool read(void *read_data, uint32_t &data_len, BLOCKING_TYPE block_type) override;
 
+    /// @brief Borrow a message in shared memory without copying it. It blocks as qosCfg::blockType_.
+    /// @param borrowedMsg store the borrowed message, release it as soon as message is processed.
+    /// @return PROCESS_SUCCESS: borrow successfully. Otherwise, borrow fail.
+    bool borrow(shmBorrowedMsg &borrowedMsg);
+
+    /// @brief Borrow a message in shared memory without copying it. It can choose blocking or non-blocking.
+    /// @param borrowedMsg store the borrowed message, release it as soon as message is processed.
+    /// @param block_type blocking or non-blocking
+    /// @return PROCESS_SUCCESS: borrow successfully. Otherwise, borrow fail.
+    bool borrow(shmBorrowedMsg &borrowedMsg, BLOCKING_TYPE block_type);
+
+    /// @brief Read pending messages in one pass. RELIABLE reader drains up to maxCount messages,
+    ///        EFFICIENT reader only reads the latest one.
+    /// @param callback called with every message, data is valid only during the call.
+    /// @param maxCount most messages to read.
+    /// @param readCount number of read messages.
+    /// @param block_type waiting type if no message is pending.
+    /// @return PROCESS_SUCCESS: read at least one message. Otherwise, read fail.
+    bool readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, BLOCKING_TYPE block_type);
+
     virtual bool wait() override;
 
+    /// @brief Channel notified by every publish of topic, waiters outside transport park on it.
+    std::shared_ptr<shmChannel> getChannel();
+
+    /// @brief Pollable fd which turns readable when topic is published, register it to epoll with EPOLLIN.
+    ///        Call clearEvent() when it is readable, then drain topic by NON_BLOCK reads.
+    ///        Property: non thread safe, get it before transport is shared by threads.
+    /// @note Eventfd is created on first call and closed with transport. It is signaled once at once
+    ///       if messages are already pending.
+    /// @return INVALID_VALUE if eventfd can't be created.
+    int getEventFd();
+
+    /// @brief Consume readiness of event fd.
+    void clearEvent();
+
     std::unique_ptr<tpController>  tpController_ptr_;
+    /// @brief Blocking type of read and borrow which don't pass one.
+    BLOCKING_TYPE                  blockType_ = BLOCKING_TYPE::BLOCK;
+
+    protected:
+    /// @brief Stop bridging notifications of topic to event fd and close it.
+    void closeEventFd();
+
+    int                               eventFd_ = INVALID_VALUE;
+    std::shared_ptr<shmEventBridge>   eventBridge_ptr_;
   };
 
   template<typename FUNC_T>
   void shmChannel::waitNotify(FUNC_T&& func)
   {
-    using namespace BI;
-    scoped_lock<interprocess_mutex> lock(ipc_ptr_->mechanism_raw_ptr_->mutex_);
-    ipc_ptr_->mechanism_raw_ptr_->condition_.wait(lock, std::forward<FUNC_T>(func));
+    for (;;)
+    {
+      auto sequence = channel_raw_ptr_->notifySequence_.load(std::memory_order_acquire);
+      if (func())
+      {
+        return;
+      }
+      parkWait(sequence, nullptr);
+    }
   }
 
   template<typename FUNC_T>
   bool shmChannel::tryWaitNotify(FUNC_T&& func, uint32_t microsecond)
   {
-    using namespace BI;
-    scoped_lock<interprocess_mutex> lock(ipc_ptr_->mechanism_raw_ptr_->mutex_);
-    return ipc_ptr_->mechanism_raw_ptr_->condition_.timed_wait(lock, \
-      boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds(microsecond), func);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(microsecond);
+    for (;;)
+    {
+      auto sequence = channel_raw_ptr_->notifySequence_.load(std::memory_order_acquire);
+      if (func())
+      {
+        return true;
+      }
+      if (parkWait(sequence, &deadline) == PROCESS_FAIL)
+      {
+        return func();
+      }
+    }
   }
 
-  /// @brief Get a microsecond timestamp.
-  ///         !!!WARN!!! This timestamp will be truncated to 32 bits.
-  /// @return microsecond timestamp.
-  uint32_t  getTimestamp();
+  /// @brief Get a nanosecond timestamp.
+  /// @return nanosecond timestamp.
+  uint64_t  getTimestamp();
 
 }
 
@@ -1,6 +1,7 @@
 #ifndef __SHM_TRANSPORT_CONTROLLER_H__
 #define __SHM_TRANSPORT_CONTROLLER_H__
 #include <atomic>
+#include <mutex>
 
 #include "qosController.h"
 #include "shmTransport.h"
@@ -21,6 +22,10 @@ namespace dawn
     /// @return 
     virtual bool initialize(std::any config) override;
     virtual bool write(const void *write_data, const uint32_t data_len) override;
+    virtual bool write(const iovec *iov, int iovcnt) override;
+    virtual bool writeBatch(const iovec *msgs, uint32_t msgNum) override;
+    virtual bool loan(const uint32_t data_len, shmLoanedMsg &loanedMsg) override;
+    virtual bool publish(shmLoanedMsg &loanedMsg) override;
 
     /// @brief Read data efficiently. Support multi-thread read.
     ///        Property: thread safe.
@@ -30,21 +35,44 @@ namespace dawn
     /// @return PROCESS_SUCCESS if read data successfully, otherwise return PROCESS_FAILED.
     virtual bool read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type) override;
 
+    /// @brief Borrow the latest message without copying it.
+    ///        Property: thread safe.
+    /// @param borrowedMsg store the borrowed message.
+    /// @param block_type BLOCK or NON_BLOCK read
+    /// @return PROCESS_SUCCESS if borrow successfully, otherwise return PROCESS_FAILED.
+    virtual bool borrow(shmBorrowedMsg &borrowedMsg, abstractTransport::BLOCKING_TYPE block_type) override;
+
+    /// @brief Read the latest fresh message, efficient reader never drains older messages.
+    ///        Property: thread safe.
+    /// @param callback called with the message.
+    /// @param maxCount
+    /// @param readCount 1 if a message is read, otherwise 0.
+    /// @param block_type
+    /// @return PROCESS_SUCCESS if a message is read, otherwise return PROCESS_FAILED.
+    virtual bool readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, abstractTransport::BLOCKING_TYPE block_type) override;
+
     virtual qosCfg::QOS_TYPE getQosType() override;
+    virtual std::shared_ptr<shmChannel> getChannel() override;
 
-    /// @brief deliver a message pointer.Using std::any to implement polymorphism.
-    /// @param msg message pointer
-    /// @return 
-    MSG_FRESHNESS tasteMsgType(shmIndexRingBuffer::ringBufferIndexBlockType &msg);
+    /// @brief Taste a message by its ring buffer sequence.
+    /// @param ringBufferIndex sequence of message in ring buffer.
+    /// @return FRESH if the message is newer than the latest read one.
+    MSG_FRESHNESS tasteMsgType(uint64_t ringBufferIndex);
 
     /// @brief Record a message pointer like a ring buffer index block or a entire message, which depends on the scenario.
     ///       No thread safe.
     /// @param msg 
+    /// @param ringBufferIndex sequence of message in ring buffer.
     /// @return PROCESS_SUCCESS if the msg is recorded successfully, otherwise return PROCESS_FAILED.
-    bool updateLatestMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg);
+    bool updateLatestMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint64_t ringBufferIndex);
     private:
+    /// @brief Find the latest fresh message and hand it to consumeFunc, which copies or borrows it.
+    template<typename FUNC_T>
+    bool consumeMsg(FUNC_T &&consumeFunc, abstractTransport::BLOCKING_TYPE block_type);
+
     std::shared_mutex                                 mutex_;
     shmIndexRingBuffer::ringBufferIndexBlockType      latestMsg_;
+    uint64_t                                          latestIndex_ = SHM_INVALID_SEQUENCE;
     qosCfg                                            qosCfg_;
     std::unique_ptr<shmTransportImpl>                 shmImpl_;
   };
@@ -54,7 +82,7 @@ namespace dawn
     reliableTpController_shm() = delete;
     reliableTpController_shm(std::unique_ptr<shmTransportImpl> &&shmTp);
     reliableTpController_shm(std::unique_ptr<shmTransportImpl> &&shmTp, std::any config);
-    virtual ~reliableTpController_shm() = default;
+    virtual ~reliableTpController_shm();
 
     /// @brief Deliver config to decide transport control.
     /// @param ringBuffer_ 
@@ -66,6 +94,10 @@ namespace dawn
     /// @param data_len data length.
     /// @return PROCESS_SUCCESS if write data successfully, otherwise return PROCESS_FAILED.
     virtual bool write(const void *write_data, const uint32_t data_len) override;
+    virtual bool write(const iovec *iov, int iovcnt) override;
+    virtual bool writeBatch(const iovec *msgs, uint32_t msgNum) override;
+    virtual bool loan(const uint32_t data_len, shmLoanedMsg &loanedMsg) override;
+    virtual bool publish(shmLoanedMsg &loanedMsg) override;
     /// @brief Read data reliably.
     ///        Property: thread safe.
     /// @param read_data Data to be store.
@@ -73,38 +105,71 @@ namespace dawn
     /// @param block_type Blocking or non-blocking read.
     /// @return PROCESS_SUCCESS if read data successfully, otherwise return PROCESS_FAILED.
     virtual bool read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type) override;
+    /// @brief Borrow the next message reliably without copying it.
+    ///        Property: thread safe.
+    /// @param borrowedMsg store the borrowed message.
+    /// @param block_type Blocking or non-blocking read.
+    /// @return PROCESS_SUCCESS if borrow successfully, otherwise return PROCESS_FAILED.
+    virtual bool borrow(shmBorrowedMsg &borrowedMsg, abstractTransport::BLOCKING_TYPE block_type) override;
+    /// @brief Read pending messages from stay index to end of one ring buffer snapshot in one pass.
+    ///        Property: thread safe, concurrent callers never get the same message.
+    /// @param callback called with every message in order.
+    /// @param maxCount most messages to read.
+    /// @param readCount number of messages handed to callback.
+    /// @param block_type Waiting type if no message is pending.
+    /// @return PROCESS_SUCCESS if any message is read, otherwise return PROCESS_FAILED.
+    virtual bool readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, abstractTransport::BLOCKING_TYPE block_type) override;
     virtual qosCfg::QOS_TYPE getQosType() override;
+    virtual std::shared_ptr<shmChannel> getChannel() override;
 
-    MSG_FRESHNESS tasteMsgAtStartIndex(shmIndexRingBuffer::ringBufferIndexBlockType &startMsg, uint32_t ringBufferIndex);
-    MSG_FRESHNESS tasteMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint32_t ringBufferIndex);
+    MSG_FRESHNESS tasteMsgAtStartIndex(shmIndexRingBuffer::ringBufferIndexBlockType &startMsg, uint64_t ringBufferIndex);
+    MSG_FRESHNESS tasteMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint64_t ringBufferIndex);
     bool updateLastMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg);
-    bool updateStartMsgAndIndex(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint32_t ringBufferIndex);
+    bool updateStartMsgAndIndex(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint64_t ringBufferIndex);
 
     /// @brief Update stay index.
     /// @param updatedIndex Return the caller the updated stay index.
-    /// @param ringBufferIndex If ringBufferIndex is SHM_INVALID_INDEX, then stayIndex_ will be added by 1.
+    /// @param ringBufferIndex If ringBufferIndex is SHM_INVALID_SEQUENCE, then stayIndex_ will be added by 1.
     ///                        Otherwise, stayIndex_ will be updated by ringBufferIndex.
     /// @return PROCESS_SUCCESS if the stay index is updated successfully, otherwise return PROCESS_FAILED.
-    bool updateStayIndex(uint32_t &updatedIndex, uint32_t ringBufferIndex);
+    bool updateStayIndex(uint64_t &updatedIndex, uint64_t ringBufferIndex);
 
     /// @brief Update stay index.
     /// @param updatedIndex Return the caller the updated stay index.
-    /// @param ringBufferIndex If ringBufferIndex is SHM_INVALID_INDEX, then stayIndex_ will be added by 1.
+    /// @param ringBufferIndex If ringBufferIndex is SHM_INVALID_SEQUENCE, then stayIndex_ will be added by 1.
     ///                        Otherwise, stayIndex_ will be updated by ringBufferIndex.
     /// @return PROCESS_SUCCESS if the stay index is updated successfully, otherwise return PROCESS_FAILED.
-    bool updateStayIndex(uint32_t &updatedIndex);
+    bool updateStayIndex(uint64_t &updatedIndex);
 
     private:
+    /// @brief Find the next message of this reader and hand it to consumeFunc, which copies or borrows it.
+    template<typename FUNC_T>
+    bool consumeMsg(FUNC_T &&consumeFunc, abstractTransport::BLOCKING_TYPE block_type);
+
+    /// @brief Claim pending messages up to maxCount and hand them to callback.
+    /// @param buffer scratch buffer to copy messages.
+    /// @return number of messages handed to callback.
+    uint32_t drainMsg(const batchReadFunc &callback, uint32_t maxCount, std::vector<char> &buffer);
+
+    /// @brief Register cursor of this reader in ring buffer on first read, restart reading if publisher evicted it.
+    void attachReaderCursor();
+
+    /// @brief Publish stay index as cursor of this reader, so publishers don't recycle unread messages.
+    void publishReaderCursor();
+
     std::shared_mutex                                 lastMsgMutex_;
     std::shared_mutex                                 startMsgMutex_;
     shmIndexRingBuffer::ringBufferIndexBlockType      lastBlock_;
     shmIndexRingBuffer::ringBufferIndexBlockType      startBlock_;
 
     /// @todo use atomic variable to replace the following two variables.
-    std::atomic<uint32_t>                             stayIndex_ = SHM_INVALID_INDEX;
-    uint32_t                                          recordStartIndex_ = SHM_INVALID_INDEX;
+    std::atomic<uint64_t>                             stayIndex_ = SHM_INVALID_SEQUENCE;
+    uint64_t                                          recordStartIndex_ = SHM_INVALID_SEQUENCE;
     qosCfg                                            qosCfg_;
     std::unique_ptr<shmTransportImpl>                 shmImpl_;
+    std::once_flag                                    readerOnceFlag_;
+    /// @brief Slot of reader cursor in ring buffer, it is registered only when this controller reads.
+    uint32_t                                          readerId_ = SHM_INVALID_INDEX;
   };
 };
 
@@ -0,0 +1,65 @@
+#ifndef _SHM_WAIT_SET_H_
+#define _SHM_WAIT_SET_H_
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "shmTransport.h"
+
+namespace dawn
+{
+  /// @brief Block one thread on many topics and tell which of them are ready.
+  ///        Property: non thread safe, it serves one reactor thread.
+  /// @note Readiness is edge triggered. A topic is reported once after it is published, reported topic should be
+  ///       drained by NON_BLOCK reads until they fail. Topic is reported by the first wait after it is attached,
+  ///       so messages which are already pending are drained too.
+  struct shmWaitSet
+  {
+    shmWaitSet() = default;
+    ~shmWaitSet() = default;
+
+    /// @brief Add transport of a topic to wait set.
+    /// @return index reported by wait, SHM_INVALID_INDEX if set already holds SHM_WAIT_CHANNEL_MAX_NUM topics.
+    uint32_t attach(std::shared_ptr<shmTransport> transport_ptr);
+
+    /// @brief Remove a topic, its index may be reused by later attach.
+    /// @return PROCESS_FAIL if index is not attached.
+    bool detach(uint32_t index);
+
+    /// @return nullptr if index is not attached.
+    std::shared_ptr<shmTransport> getTransport(uint32_t index) const;
+
+    /// @brief Number of attached topics.
+    uint32_t size() const;
+
+    /// @brief Block until any topic is ready.
+    /// @param readyVec indexes of ready topics.
+    /// @return PROCESS_SUCCESS if any topic is ready, PROCESS_FAIL if set is empty.
+    bool wait(std::vector<uint32_t> &readyVec);
+
+    /// @brief Block until any topic is ready or timeout.
+    /// @param readyVec indexes of ready topics.
+    /// @param microseconds 0 only collects topics which are already ready.
+    /// @return PROCESS_SUCCESS if any topic is ready, PROCESS_FAIL if timeout or set is empty.
+    bool waitFor(std::vector<uint32_t> &readyVec, uint32_t microseconds);
+
+    protected:
+    struct entryType
+    {
+      std::shared_ptr<shmTransport>   transport_ptr_;
+      std::shared_ptr<shmChannel>     channel_ptr_;
+      /// @brief Notify sequence when topic was reported last time.
+      uint32_t                        seenSequence_ = 0;
+    };
+
+    bool waitUntil(std::vector<uint32_t> &readyVec, const std::chrono::steady_clock::time_point *deadline);
+
+    std::vector<entryType>    entryVec_;
+    uint32_t                  entryNum_ = 0;
+    /// @brief Scratch arrays handed to shmChannel::parkWaitAny.
+    std::vector<shmChannel*>  channelVec_;
+    std::vector<uint32_t>     sequenceVec_;
+  };
+}
+
+#endif
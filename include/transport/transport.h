@@ -1,5 +1,7 @@
 #ifndef __TRANSPORT_H__
 #define __TRANSPORT_H__
+#include <sys/uio.h>
+
 #include "common/type.h"
 
 namespace dawn
@@ -9,9 +11,15 @@ namespace dawn
     enum class BLOCKING_TYPE
     {
       BLOCK,
-      NON_BLOCK
+      NON_BLOCK,
+      /// @brief Spin on new messages without parking, reader should own a pinned core.
+      BUSY_POLL,
+      /// @brief Spin for a budget, then park like BLOCK.
+      ADAPTIVE
     };
     virtual bool write(const void *write_data, const uint32_t data_len) = 0;
+    /// @brief Gather fragments into one message.
+    virtual bool write(const iovec *iov, int iovcnt) = 0;
     virtual bool read(void *read_data, uint32_t &data_len) = 0;
     virtual bool read(void *read_data, uint32_t &data_len, BLOCKING_TYPE block_type) = 0;
     virtual bool wait() = 0;
@@ -0,0 +1,121 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "memoryPolicy.h"
+#include "setLogger.h"
+
+namespace dawn
+{
+  static memoryPolicy processMemoryPolicy;
+
+  void setMemoryPolicy(const memoryPolicy &policy)
+  {
+    processMemoryPolicy = policy;
+  }
+
+  memoryPolicy getMemoryPolicy()
+  {
+    return processMemoryPolicy;
+  }
+
+  /// @brief Fault in pages of region without changing its content.
+  /// @param privateRegion fresh private region is zero filled, so writing zero faults it in writable.
+  static void prefaultRegion(void *addr, size_t len, bool privateRegion)
+  {
+    if (madvise(addr, len, MADV_POPULATE_WRITE) == 0)
+    {
+      return;
+    }
+    //Kernel before 5.14 doesn't know MADV_POPULATE_WRITE, so touch every page.
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < len; offset += pageSize)
+    {
+      auto page = reinterpret_cast<volatile char*>(addr) + offset;
+      if (privateRegion)
+      {
+        *page = 0;
+      }
+      else
+      {
+        (void)*page;
+      }
+    }
+  }
+
+  static void lockRegion(void *addr, size_t len)
+  {
+    if (mlock(addr, len) != 0)
+    {
+      LOG_WARN("can not lock {} bytes in RAM: {}", len, strerror(errno));
+    }
+  }
+
+  void applyMemoryPolicy(void *addr, size_t len)
+  {
+    auto policy = processMemoryPolicy;
+    if (policy.hugePage_ && madvise(addr, len, MADV_HUGEPAGE) != 0)
+    {
+      LOG_WARN("can not advise transparent hugepage for {} bytes: {}", len, strerror(errno));
+    }
+    if (policy.prefault_)
+    {
+      prefaultRegion(addr, len, false);
+    }
+    if (policy.lock_)
+    {
+      lockRegion(addr, len);
+    }
+  }
+
+  void* allocRegion(size_t &len)
+  {
+    auto policy = processMemoryPolicy;
+    void *addr = MAP_FAILED;
+    if (policy.hugePage_)
+    {
+      auto hugeLen = (len + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+      addr = mmap(nullptr, hugeLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | \
+        (policy.prefault_ ? MAP_POPULATE : 0), -1, 0);
+      if (addr != MAP_FAILED)
+      {
+        len = hugeLen;
+      }
+      else
+      {
+        LOG_INFO("no hugepage is reserved for {} bytes, fall back to transparent hugepage", hugeLen);
+      }
+    }
+
+    if (addr == MAP_FAILED)
+    {
+      ///@note Advice must come before the first touch, so region is prefaulted after mmap.
+      addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr == MAP_FAILED)
+      {
+        LOG_ERROR("can not map {} bytes: {}", len, strerror(errno));
+        return nullptr;
+      }
+      if (policy.hugePage_)
+      {
+        madvise(addr, len, MADV_HUGEPAGE);
+      }
+      if (policy.prefault_)
+      {
+        prefaultRegion(addr, len, true);
+      }
+    }
+
+    if (policy.lock_)
+    {
+      lockRegion(addr, len);
+    }
+    return addr;
+  }
+
+  void freeRegion(void *addr, size_t len)
+  {
+    munmap(addr, len);
+  }
+}
@@ -5,6 +5,7 @@
 #include "stdlib.h"
 #include "string.h"
 #include "baseOperator.h"
+#include "memoryPolicy.h"
 
 namespace dawn
 {
@@ -22,13 +23,17 @@ namespace dawn
     {
       int memBlockSize = BASE_BLOCK_SIZE * (i + 1);
       int totalMemBlockNum = EACH_BLOCK_TOTAL_NUM.array[i];
-      mallocMemory = (memoryNode_t *)malloc(totalMemBlockNum * (sizeof(memoryNode_t) + memBlockSize));
+      size_t slabSize = totalMemBlockNum * (sizeof(memoryNode_t) + memBlockSize);
+      mallocMemory = (memoryNode_t *)allocRegion(slabSize);
+      if (mallocMemory == nullptr)
+      {
+        throw std::runtime_error("dawn: can not allocate slab of memory pool");
+      }
       mallocLFNode = new LF_node_t<memoryNode_t *>[totalMemBlockNum];
 
-      allCreateMem_.push_back((void *)mallocMemory);
+      allCreateSlab_.emplace_back((void *)mallocMemory, slabSize);
       allCreateMem_.push_back((void *)mallocLFNode);
 
-      memset(mallocMemory, 0x0, (sizeof(memoryNode_t) + memBlockSize));
       if (mallocMemory != nullptr && mallocLFNode != nullptr)
       {
         char *tempMallocMemory = reinterpret_cast<char *>(mallocMemory);
@@ -53,6 +58,11 @@ namespace dawn
       free(freeMemIt);
     }
     allCreateMem_.clear();
+    for (auto &slab : allCreateSlab_)
+    {
+      freeRegion(slab.first, slab.second);
+    }
+    allCreateSlab_.clear();
   }
 
   memoryNode_t* memoryPool::allocMemBlock(const int requestMemSize)
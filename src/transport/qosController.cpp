@@ -7,5 +7,6 @@ namespace dawn
     qosCfg()
   {
     qosType_ = qosCfg::QOS_TYPE::RELIABLE;
+    fullPolicy_ = qosCfg::FULL_POLICY::BLOCK;
   }
 }
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+
+#include "shmEventBridge.h"
+#include "common/setLogger.h"
+
+namespace dawn
+{
+  std::shared_ptr<shmEventBridge> shmEventBridge::getEventBridge()
+  {
+    static std::mutex bridgeMutex;
+    static std::weak_ptr<shmEventBridge> bridge_weak_ptr;
+    std::lock_guard<std::mutex> lock(bridgeMutex);
+    auto bridge_ptr = bridge_weak_ptr.lock();
+    if (!bridge_ptr)
+    {
+      bridge_ptr = std::make_shared<shmEventBridge>();
+      bridge_weak_ptr = bridge_ptr;
+    }
+    return bridge_ptr;
+  }
+
+  shmEventBridge::shmEventBridge():
+    wakeupChannel_("event_bridge_wakeup", &wakeupIpc_)
+  {
+    thread_ = std::make_unique<std::thread>([this]() { bridgeRun(); });
+  }
+
+  shmEventBridge::~shmEventBridge()
+  {
+    runFlag_.store(false, std::memory_order_release);
+    wakeupChannel_.notifyAll();
+    if (thread_ && thread_->joinable())
+    {
+      thread_->join();
+    }
+  }
+
+  bool shmEventBridge::registerEventFd(int eventFd, std::shared_ptr<shmChannel> channel_ptr)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (notifierVec_.size() + 1 >= SHM_WAIT_CHANNEL_MAX_NUM)
+      {
+        LOG_ERROR("event bridge is full, it watches {} topics", notifierVec_.size());
+        return PROCESS_FAIL;
+      }
+      //Differ from current sequence, so messages which are already pending signal eventFd.
+      auto sequence = channel_ptr->getNotifySequence() - 1;
+      notifierVec_.emplace_back(notifierType{eventFd, std::move(channel_ptr), sequence});
+    }
+    wakeupChannel_.notifyAll();
+    return PROCESS_SUCCESS;
+  }
+
+  bool shmEventBridge::unregisterEventFd(int eventFd)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto iter = std::find_if(notifierVec_.begin(), notifierVec_.end(), \
+        [eventFd](const notifierType &notifier) { return notifier.eventFd_ == eventFd; });
+      if (iter == notifierVec_.end())
+      {
+        return PROCESS_FAIL;
+      }
+      notifierVec_.erase(iter);
+    }
+    wakeupChannel_.notifyAll();
+    return PROCESS_SUCCESS;
+  }
+
+  void shmEventBridge::signalEventFd(int eventFd)
+  {
+    uint64_t count = 1;
+    //Eventfd is non-blocking, a counter which is about to overflow is readable anyway.
+    if (write(eventFd, &count, sizeof(count)) != sizeof(count) && errno != EAGAIN)
+    {
+      LOG_WARN("can not signal eventfd {}: {}", eventFd, strerror(errno));
+    }
+  }
+
+  void shmEventBridge::bridgeRun()
+  {
+    std::vector<std::shared_ptr<shmChannel>> channelHolderVec;
+    std::vector<shmChannel*> channelVec;
+    std::vector<uint32_t> sequenceVec;
+    while (runFlag_.load(std::memory_order_acquire))
+    {
+      channelHolderVec.clear();
+      channelVec.clear();
+      sequenceVec.clear();
+      channelVec.push_back(&wakeupChannel_);
+      sequenceVec.push_back(wakeupChannel_.getNotifySequence());
+      {
+        ///@note Eventfds are signaled under mutex_, so an unregistered eventfd is never written after it is closed.
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &notifier : notifierVec_)
+        {
+          auto sequence = notifier.channel_ptr_->getNotifySequence();
+          if (sequence != notifier.seenSequence_)
+          {
+            notifier.seenSequence_ = sequence;
+            signalEventFd(notifier.eventFd_);
+          }
+          channelHolderVec.push_back(notifier.channel_ptr_);
+          channelVec.push_back(notifier.channel_ptr_.get());
+          sequenceVec.push_back(sequence);
+        }
+      }
+
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_EVENT_BRIDGE_REFRESH_MS);
+      shmChannel::parkWaitAny(channelVec.data(), sequenceVec.data(), static_cast<uint32_t>(channelVec.size()), &deadline);
+    }
+  }
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+
+#include "shmListener.h"
+#include "common/setLogger.h"
+
+namespace dawn
+{
+  shmListener::shmListener(uint32_t listenerNum)
+  {
+    listenerNum = std::max(1U, listenerNum);
+    for (uint32_t i = 0; i < listenerNum; i++)
+    {
+      listenerVec_.emplace_back(std::make_unique<listenerType>());
+    }
+    for (auto &listener_ptr : listenerVec_)
+    {
+      auto listener_raw_ptr = listener_ptr.get();
+      listener_ptr->thread_ = std::make_unique<std::thread>([this, listener_raw_ptr]() { listenerRun(*listener_raw_ptr); });
+    }
+  }
+
+  shmListener::~shmListener()
+  {
+    stop();
+  }
+
+  void shmListener::stop()
+  {
+    runFlag_.store(false, std::memory_order_release);
+    for (auto &listener_ptr : listenerVec_)
+    {
+      if (listener_ptr->thread_ && listener_ptr->thread_->joinable())
+      {
+        listener_ptr->thread_->join();
+      }
+    }
+  }
+
+  uint32_t shmListener::subscribe(std::string_view topic, const batchReadFunc &callback, std::shared_ptr<threadPool> executor, \
+    std::shared_ptr<qosCfg> qosCfg_ptr)
+  {
+    if (!callback || !executor)
+    {
+      LOG_ERROR("subscribe topic {} without callback or executor", topic);
+      return SHM_INVALID_INDEX;
+    }
+
+    //The least loaded listener takes the new subscription.
+    listenerType *listener_raw_ptr = nullptr;
+    size_t subscriptionNum = SHM_WAIT_CHANNEL_MAX_NUM;
+    for (auto &listener_ptr : listenerVec_)
+    {
+      std::lock_guard<std::mutex> lock(listener_ptr->mutex_);
+      if (listener_ptr->subscriptionVec_.size() < subscriptionNum)
+      {
+        subscriptionNum = listener_ptr->subscriptionVec_.size();
+        listener_raw_ptr = listener_ptr.get();
+      }
+    }
+    if (listener_raw_ptr == nullptr)
+    {
+      LOG_ERROR("listeners are full, topic {} is not subscribed", topic);
+      return SHM_INVALID_INDEX;
+    }
+
+    auto subscription_ptr = std::make_shared<subscriptionType>();
+    subscription_ptr->id_ = nextSubscriptionId_.fetch_add(1, std::memory_order_relaxed);
+    subscription_ptr->transport_ptr_ = std::make_shared<shmTransport>(topic, qosCfg_ptr);
+    subscription_ptr->channel_ptr_ = subscription_ptr->transport_ptr_->getChannel();
+    subscription_ptr->callback_ = callback;
+    subscription_ptr->executor_ptr_ = executor;
+    //Differ from current sequence, so messages published before subscribing are drained at once.
+    subscription_ptr->seenSequence_.store(subscription_ptr->channel_ptr_->getNotifySequence() - 1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(listener_raw_ptr->mutex_);
+    if (listener_raw_ptr->subscriptionVec_.size() >= SHM_WAIT_CHANNEL_MAX_NUM)
+    {
+      LOG_ERROR("listener is full, topic {} is not subscribed", topic);
+      return SHM_INVALID_INDEX;
+    }
+    listener_raw_ptr->subscriptionVec_.push_back(subscription_ptr);
+    listener_raw_ptr->changed_.store(true, std::memory_order_release);
+    return subscription_ptr->id_;
+  }
+
+  bool shmListener::unsubscribe(uint32_t subscriptionId)
+  {
+    std::shared_ptr<subscriptionType> subscription_ptr;
+    for (auto &listener_ptr : listenerVec_)
+    {
+      std::lock_guard<std::mutex> lock(listener_ptr->mutex_);
+      auto &subscriptionVec = listener_ptr->subscriptionVec_;
+      auto iter = std::find_if(subscriptionVec.begin(), subscriptionVec.end(), \
+        [subscriptionId](const std::shared_ptr<subscriptionType> &item) { return item->id_ == subscriptionId; });
+      if (iter != subscriptionVec.end())
+      {
+        subscription_ptr = *iter;
+        subscriptionVec.erase(iter);
+        listener_ptr->changed_.store(true, std::memory_order_release);
+        break;
+      }
+    }
+    if (!subscription_ptr)
+    {
+      return PROCESS_FAIL;
+    }
+
+    ///@note Listener may still hold subscription until its next refresh, a task it dispatches later sees
+    ///      cancelled_ and doesn't call callback.
+    subscription_ptr->cancelled_.store(true, std::memory_order_seq_cst);
+    while (subscription_ptr->dispatching_.load(std::memory_order_seq_cst))
+    {
+      std::this_thread::yield();
+    }
+    return PROCESS_SUCCESS;
+  }
+
+  void shmListener::listenerRun(listenerType &listener)
+  {
+    std::vector<std::shared_ptr<subscriptionType>> subscriptionVec;
+    std::vector<shmChannel*> channelVec;
+    std::vector<uint32_t> sequenceVec;
+    listener.changed_.store(true, std::memory_order_release);
+    while (runFlag_.load(std::memory_order_acquire))
+    {
+      if (listener.changed_.exchange(false, std::memory_order_acq_rel))
+      {
+        std::lock_guard<std::mutex> lock(listener.mutex_);
+        subscriptionVec = listener.subscriptionVec_;
+        channelVec.clear();
+        for (auto &subscription_ptr : subscriptionVec)
+        {
+          channelVec.push_back(subscription_ptr->channel_ptr_.get());
+        }
+        sequenceVec.resize(subscriptionVec.size());
+      }
+
+      for (size_t i = 0; i < subscriptionVec.size(); i++)
+      {
+        auto &subscription_ptr = subscriptionVec[i];
+        sequenceVec[i] = channelVec[i]->getNotifySequence();
+        //Topic with a task in flight is skipped, the task checks notify sequence again before it ends.
+        if (sequenceVec[i] != subscription_ptr->seenSequence_.load(std::memory_order_relaxed) && \
+          subscription_ptr->dispatching_.exchange(true, std::memory_order_seq_cst) == false)
+        {
+          dispatch(subscription_ptr);
+        }
+      }
+
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_LISTENER_REFRESH_MS);
+      if (subscriptionVec.empty())
+      {
+        std::this_thread::sleep_until(deadline);
+        continue;
+      }
+      shmChannel::parkWaitAny(channelVec.data(), sequenceVec.data(), static_cast<uint32_t>(channelVec.size()), &deadline);
+    }
+  }
+
+  void shmListener::dispatch(const std::shared_ptr<subscriptionType> &subscription_ptr)
+  {
+    subscription_ptr->executor_ptr_->pushWorkQueue([subscription_ptr]() { drain(subscription_ptr); });
+  }
+
+  void shmListener::drain(const std::shared_ptr<subscriptionType> &subscription_ptr)
+  {
+    auto sequence = subscription_ptr->channel_ptr_->getNotifySequence();
+    subscription_ptr->seenSequence_.store(sequence, std::memory_order_relaxed);
+    uint32_t readCount = 0;
+    if (!subscription_ptr->cancelled_.load(std::memory_order_seq_cst))
+    {
+      subscription_ptr->transport_ptr_->readBatch(subscription_ptr->callback_, SHM_LISTENER_DRAIN_NUM, readCount, \
+        abstractTransport::BLOCKING_TYPE::NON_BLOCK);
+    }
+    if (readCount == SHM_LISTENER_DRAIN_NUM)
+    {
+      //More messages may be pending, queue again so other topics on executor get their turn.
+      dispatch(subscription_ptr);
+      return;
+    }
+
+    subscription_ptr->dispatching_.store(false, std::memory_order_seq_cst);
+    //Listener skips a publish landing while this task runs, so pick it up here.
+    if (subscription_ptr->channel_ptr_->getNotifySequence() != sequence && \
+      !subscription_ptr->cancelled_.load(std::memory_order_seq_cst) && \
+      subscription_ptr->dispatching_.exchange(true, std::memory_order_seq_cst) == false)
+    {
+      dispatch(subscription_ptr);
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <chrono>
+
+#include "shmReclaimer.h"
+#include "shmTransport.h"
+#include "shmTransportImpl.hh"
+#include "common/setLogger.h"
+
+namespace dawn
+{
+  std::shared_ptr<shmReclaimer> shmReclaimer::getReclaimer()
+  {
+    static std::mutex reclaimerMutex;
+    static std::weak_ptr<shmReclaimer> reclaimer_weak_ptr;
+    std::lock_guard<std::mutex> lock(reclaimerMutex);
+    auto reclaimer_ptr = reclaimer_weak_ptr.lock();
+    if (!reclaimer_ptr)
+    {
+      reclaimer_ptr = std::make_shared<shmReclaimer>();
+      reclaimer_weak_ptr = reclaimer_ptr;
+    }
+    return reclaimer_ptr;
+  }
+
+  shmReclaimer::shmReclaimer()
+  {
+    thread_ = std::make_unique<std::thread>([this]() { reclaimRun(); });
+  }
+
+  shmReclaimer::~shmReclaimer()
+  {
+    runFlag_.store(false, std::memory_order_release);
+    if (thread_ && thread_->joinable())
+    {
+      thread_->join();
+    }
+  }
+
+  void shmReclaimer::registerTopic(shmTransportImpl *impl_raw_ptr)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    topicVec_.push_back(impl_raw_ptr);
+  }
+
+  void shmReclaimer::unregisterTopic(shmTransportImpl *impl_raw_ptr)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    topicVec_.erase(std::remove(topicVec_.begin(), topicVec_.end(), impl_raw_ptr), topicVec_.end());
+  }
+
+  void shmReclaimer::reclaimRun()
+  {
+    while (runFlag_.load(std::memory_order_acquire))
+    {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(SHM_RECLAIM_PERIOD_US);
+      {
+        ///@note Topics are visited under mutex_, so an unregistered topic is never touched after it is destroyed.
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto impl_raw_ptr : topicVec_)
+        {
+          impl_raw_ptr->reclaimMsg(SHM_RECLAIM_BATCH_NUM);
+        }
+      }
+      std::this_thread::sleep_until(deadline);
+    }
+  }
+}
@@ -1,8 +1,22 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <thread>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "shmTransport.h"
 #include "common/setLogger.h"
+#include "common/baseOperator.h"
+#include "common/memoryPolicy.h"
+#include "shmEventBridge.h"
 #include "shmTransportController.h"
 #include "shmTransportImpl.hh"
 
@@ -17,6 +31,20 @@ namespace  dawn
       throw std::runtime_error("dawn: shm channel identity is empty");
     }
     ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(identity_);
+    channel_raw_ptr_ = ipc_ptr_->mechanism_raw_ptr_;
+  }
+
+  shmChannel::shmChannel(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset):
+    identity_(identity),
+    channelShmRegion_ptr_(region_ptr)
+  {
+    channel_raw_ptr_ = reinterpret_cast<IPC_t*>(reinterpret_cast<char*>(channelShmRegion_ptr_->get_address()) + offset);
+  }
+
+  shmChannel::shmChannel(std::string_view identity, IPC_t *ipc_raw_ptr):
+    identity_(identity),
+    channel_raw_ptr_(ipc_raw_ptr)
+  {
   }
 
   void shmChannel::initialize(std::string_view identity)
@@ -28,544 +56,1962 @@ namespace  dawn
       throw std::runtime_error("dawn: shm channel identity is empty");
     }
     ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(identity_);
+    channel_raw_ptr_ = ipc_ptr_->mechanism_raw_ptr_;
+  }
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free, \
+    "futex word must be a plain 32-bit word");
+
+  /// @note Futex word lives in share memory mapped by many processes, so FUTEX_PRIVATE_FLAG is not used.
+  static void futexWait(std::atomic<uint32_t> &word, uint32_t expected, const struct timespec *timeout)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+  }
+
+  static void futexWakeAll(std::atomic<uint32_t> &word)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
   }
 
   void shmChannel::notifyAll()
   {
-    ipc_ptr_->mechanism_raw_ptr_->condition_.notify_all();
+    ///@note Sequence bump and waiter check are seq_cst and pair with parkWait,
+    ///      so either the waiter sees the new sequence or the publisher sees the waiter.
+    auto mechanism = channel_raw_ptr_;
+    mechanism->notifySequence_.fetch_add(1, std::memory_order_seq_cst);
+    if (mechanism->waiterNum_.load(std::memory_order_seq_cst) != 0)
+    {
+      futexWakeAll(mechanism->notifySequence_);
+    }
   }
 
   void shmChannel::waitNotify()
   {
-    using namespace BI;
-    scoped_lock<interprocess_mutex> lock(ipc_ptr_->mechanism_raw_ptr_->mutex_);
-    ipc_ptr_->mechanism_raw_ptr_->condition_.wait(lock);
+    auto sequence = channel_raw_ptr_->notifySequence_.load(std::memory_order_acquire);
+    parkWait(sequence, nullptr);
   }
 
   bool shmChannel::tryWaitNotify(uint32_t microsecond)
   {
-    using namespace BI;
-    scoped_lock<interprocess_mutex> lock(ipc_ptr_->mechanism_raw_ptr_->mutex_);
-    return ipc_ptr_->mechanism_raw_ptr_->condition_.timed_wait(lock, \
-      boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds(microsecond));
+    auto sequence = channel_raw_ptr_->notifySequence_.load(std::memory_order_acquire);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(microsecond);
+    return parkWait(sequence, &deadline);
   }
 
-  shmIndexRingBuffer::shmIndexRingBuffer(std::string_view identity):
-    shmIdentity_(identity),
-    mechanismIdentity_(MECHANISM_PREFIX + shmIdentity_)
+  bool shmChannel::parkWait(uint32_t sequence, const std::chrono::steady_clock::time_point *deadline)
   {
-    using namespace BI;
-    ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(mechanismIdentity_);
-    ringBufferShm_ptr_ = std::make_shared<shared_memory_object>(open_or_create, shmIdentity_.c_str(), read_write);
-    ringBufferShm_ptr_->truncate(SHM_RING_BUFFER_SIZE);
-    ringBufferShmRegion_ptr_ = std::make_shared<mapped_region>(*(ringBufferShm_ptr_.get()), read_write);
-    ringBuffer_raw_ptr_ = reinterpret_cast<ringBufferType*>(ringBufferShmRegion_ptr_->get_address());
+    auto mechanism = channel_raw_ptr_;
+    bool result = PROCESS_SUCCESS;
+    mechanism->waiterNum_.fetch_add(1, std::memory_order_seq_cst);
+    while (mechanism->notifySequence_.load(std::memory_order_seq_cst) == sequence)
+    {
+      if (deadline == nullptr)
+      {
+        futexWait(mechanism->notifySequence_, sequence, nullptr);
+        continue;
+      }
+      auto remain = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - std::chrono::steady_clock::now()).count();
+      if (remain <= 0)
+      {
+        result = PROCESS_FAIL;
+        break;
+      }
+      struct timespec timeout{static_cast<time_t>(remain / 1000000000), static_cast<long>(remain % 1000000000)};
+      futexWait(mechanism->notifySequence_, sequence, &timeout);
+    }
+    mechanism->waiterNum_.fetch_sub(1, std::memory_order_release);
+    return result;
+  }
 
-    ///@note ensure ringBuffer_raw_ptr_ just initialize only one time.
-    if (ipc_ptr_->mechanism_raw_ptr_->ringBufferInitializedFlag_.try_wait())
+  uint32_t shmChannel::getNotifySequence() const
+  {
+    return channel_raw_ptr_->notifySequence_.load(std::memory_order_acquire);
+  }
+
+  bool shmChannel::parkWaitAny(shmChannel *const *channels, const uint32_t *sequences, uint32_t channelNum, \
+    const std::chrono::steady_clock::time_point *deadline)
+  {
+    assert(channelNum != 0 && channelNum <= SHM_WAIT_CHANNEL_MAX_NUM);
+    bool notified = false;
+    for (uint32_t i = 0; i < channelNum; i++)
+    {
+      channels[i]->channel_raw_ptr_->waiterNum_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    for (uint32_t i = 0; i < channelNum && !notified; i++)
+    {
+      notified = (channels[i]->channel_raw_ptr_->notifySequence_.load(std::memory_order_seq_cst) != sequences[i]);
+    }
+
+    bool result = PROCESS_SUCCESS;
+    if (!notified)
+    {
+      struct timespec timeout{0, 0};
+#ifdef SYS_futex_waitv
+      struct futex_waitv waiters[SHM_WAIT_CHANNEL_MAX_NUM];
+      for (uint32_t i = 0; i < channelNum; i++)
+      {
+        waiters[i].val = sequences[i];
+        waiters[i].uaddr = reinterpret_cast<uintptr_t>(&channels[i]->channel_raw_ptr_->notifySequence_);
+        waiters[i].flags = FUTEX_32;
+        waiters[i].__reserved = 0;
+      }
+      if (deadline != nullptr)
+      {
+        //futex_waitv takes an absolute timeout, steady_clock is CLOCK_MONOTONIC.
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline->time_since_epoch()).count();
+        timeout = {static_cast<time_t>(time / 1000000000), static_cast<long>(time % 1000000000)};
+      }
+      bool waitvSupported = true;
+      if (syscall(SYS_futex_waitv, waiters, channelNum, 0, (deadline == nullptr) ? nullptr : &timeout, CLOCK_MONOTONIC) == -1)
+      {
+        result = (errno == ETIMEDOUT) ? PROCESS_FAIL : PROCESS_SUCCESS;
+        waitvSupported = (errno != ENOSYS);
+      }
+      if (!waitvSupported)
+#endif
+      {
+        //Kernel before 5.16 has no futex_waitv, park on the first channel in slices and let caller poll the others.
+        auto remain = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::microseconds(SHM_SPIN_BUDGET_US * 20)).count();
+        if (deadline != nullptr)
+        {
+          remain = std::min<int64_t>(remain, std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - std::chrono::steady_clock::now()).count());
+        }
+        if (remain <= 0)
+        {
+          result = PROCESS_FAIL;
+        }
+        else
+        {
+          timeout = {static_cast<time_t>(remain / 1000000000), static_cast<long>(remain % 1000000000)};
+          futexWait(channels[0]->channel_raw_ptr_->notifySequence_, sequences[0], &timeout);
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < channelNum; i++)
     {
-      ringBuffer_raw_ptr_->startIndex_ = SHM_INVALID_INDEX;
-      ringBuffer_raw_ptr_->endIndex_ = SHM_INVALID_INDEX;
-      ringBuffer_raw_ptr_->totalIndex_ = SHM_BLOCK_NUM;
+      channels[i]->channel_raw_ptr_->waiterNum_.fetch_sub(1, std::memory_order_release);
     }
+    return result;
   }
 
-  void shmIndexRingBuffer::initialize(std::string_view identity)
+  static_assert(sizeof(shmIndexRingBuffer::ringBufferSlotType) == SHM_INDEX_BLOCK_SIZE, "ring buffer slot size is mismatched");
+  static_assert(sizeof(shmIndexRingBuffer::ringBufferIndexBlockType) == SHM_INDEX_BLOCK_SIZE, "ring buffer index block size is mismatched");
+  static_assert(offsetof(shmIndexRingBuffer::ringBufferIndexBlockType, timeStamp_) == sizeof(uint64_t), \
+    "ring buffer slot content must start after sequence");
+  static_assert(sizeof(shmIndexRingBuffer::ringBufferType) == SHM_INDEX_RING_BUFFER_HEAD_SIZE, "ring buffer head size is mismatched");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring buffer sequence must be lock free in share memory");
+  static_assert(sizeof(msgType) == SHM_BLOCK_HEAD_SIZE, "message block head size is mismatched");
+
+  /// @brief Round size up to whole cache lines.
+  static inline uint64_t alignCacheLine(uint64_t size)
+  {
+    return (size + SHM_CACHE_LINE_SIZE - 1) / SHM_CACHE_LINE_SIZE * SHM_CACHE_LINE_SIZE;
+  }
+
+  /// @brief Make seqlock word of a slot odd for writing. A word left odd by a dead writer is taken over after
+  ///        SHM_SEQLOCK_RETRY_NUM retries on the same sequence, it stays odd, so readers still reject the half
+  ///        written value.
+  /// @param sequence seqlock word.
+  /// @param writerPid process of the writer filling slot, 0 while the word is even.
+  /// @param lockedSequence even sequence before locking, writer publishes lockedSequence + 2.
+  /// @param identity segment of slot, it is only for logs.
+  /// @return PROCESS_FAIL if the word stays odd by a live writer, or by one which died before recording its process.
+  static bool lockSeqlock(std::atomic<uint64_t> &sequence, std::atomic<uint32_t> &writerPid, uint64_t &lockedSequence, \
+    std::string_view identity)
+  {
+    //Acquire pairs with releasing store of the previous writer, so writer pid read after it is never a stale one.
+    auto current = sequence.load(std::memory_order_acquire);
+    auto stalledSequence = current;
+    for (uint32_t i = 0;; i++)
+    {
+      if ((current & 1) == 0)
+      {
+        if (sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+          break;
+        }
+        continue;
+      }
+      if (current != stalledSequence)
+      {
+        stalledSequence = current;
+        i = 0;
+      }
+      if (i < SHM_SEQLOCK_RETRY_NUM)
+      {
+        cpuRelax();
+        current = sequence.load(std::memory_order_acquire);
+        continue;
+      }
+      auto pid = writerPid.load(std::memory_order_relaxed);
+      if (pid == 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH)
+      {
+        LOG_WARN("slot of {} stays being written at {}, give up writing", identity, current);
+        return PROCESS_FAIL;
+      }
+      //Writer is dead, the writer which swaps its pid takes slot over.
+      if (writerPid.compare_exchange_strong(pid, static_cast<uint32_t>(getpid()), std::memory_order_acq_rel))
+      {
+        LOG_WARN("writer {} of {} is dead, take its slot over", pid, identity);
+        current = sequence.fetch_add(2, std::memory_order_acquire) + 1;
+        break;
+      }
+      current = sequence.load(std::memory_order_acquire);
+    }
+    writerPid.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+    //Odd sequence must be visible before any byte of value changes.
+    std::atomic_thread_fence(std::memory_order_release);
+    lockedSequence = current;
+    return PROCESS_SUCCESS;
+  }
+
+  /// @brief Publish value written under lockSeqlock.
+  static void unlockSeqlock(std::atomic<uint64_t> &sequence, std::atomic<uint32_t> &writerPid, uint64_t lockedSequence)
+  {
+    writerPid.store(0, std::memory_order_relaxed);
+    sequence.store(lockedSequence + 2, std::memory_order_release);
+  }
+
+  /// @brief Spin until predicate holds, a segment attacher uses it to wait for the creator of segment.
+  /// @throw std::runtime_error if the creator doesn't finish in SHM_SEGMENT_ATTACH_TIMEOUT_MS.
+  template<typename Predicate>
+  static void waitSegmentCreator(Predicate &&predicate)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_SEGMENT_ATTACH_TIMEOUT_MS);
+    while (predicate() == false)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        throw std::runtime_error("dawn: shm segment is not initialized by its creator");
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  shmIndexRingBuffer::shmIndexRingBuffer(std::string_view identity, uint32_t ringDepth):
+    shmIdentity_(identity),
+    mechanismIdentity_(MECHANISM_PREFIX + shmIdentity_)
+  {
+    attachRingBuffer(ringDepth);
+  }
+
+  shmIndexRingBuffer::shmIndexRingBuffer(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset, \
+    uint32_t ringDepth, bool isCreator):
+    ringBufferShmRegion_ptr_(region_ptr),
+    shmIdentity_(identity)
+  {
+    ringBuffer_raw_ptr_ = reinterpret_cast<ringBufferType*>(reinterpret_cast<char*>(ringBufferShmRegion_ptr_->get_address()) + offset);
+    formatRingBuffer(ringDepth, isCreator);
+  }
+
+  void shmIndexRingBuffer::initialize(std::string_view identity, uint32_t ringDepth)
   {
-    using namespace BI;
     shmIdentity_ = identity;
     mechanismIdentity_ = MECHANISM_PREFIX + shmIdentity_;
+    attachRingBuffer(ringDepth);
+  }
+
+  void shmIndexRingBuffer::attachRingBuffer(uint32_t ringDepth)
+  {
+    using namespace BI;
+    auto ringBufferSize = calculateRingBufferSize(ringDepth);
     ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(mechanismIdentity_);
     ringBufferShm_ptr_ = std::make_shared<shared_memory_object>(open_or_create, shmIdentity_.c_str(), read_write);
-    ringBufferShm_ptr_->truncate(SHM_RING_BUFFER_SIZE);
-    ringBufferShmRegion_ptr_ = std::make_shared<mapped_region>(*(ringBufferShm_ptr_.get()), read_write);
-    ringBuffer_raw_ptr_ = reinterpret_cast<ringBufferType*>(ringBufferShmRegion_ptr_->get_address());
 
     ///@note ensure ringBuffer_raw_ptr_ just initialize only one time.
-    if (ipc_ptr_->mechanism_raw_ptr_->ringBufferInitializedFlag_.try_wait())
+    ///      Truncated share memory is zero filled, so all sequences already start at 0.
+    ///      Attachers map the size chosen by the creator and take depth from the head.
+    bool isCreator = ipc_ptr_->mechanism_raw_ptr_->ringBufferInitializedFlag_.try_wait();
+    if (isCreator)
+    {
+      ringBufferShm_ptr_->truncate(ringBufferSize);
+    }
+    else
     {
-      ringBuffer_raw_ptr_->startIndex_ = SHM_INVALID_INDEX;
-      ringBuffer_raw_ptr_->endIndex_ = SHM_INVALID_INDEX;
-      ringBuffer_raw_ptr_->totalIndex_ = SHM_BLOCK_NUM;
+      waitSegmentCreator([this]() {
+        offset_t currentSize = 0;
+        return ringBufferShm_ptr_->get_size(currentSize) && currentSize > SHM_INDEX_RING_BUFFER_HEAD_SIZE;
+      });
     }
+    ringBufferShmRegion_ptr_ = std::make_shared<mapped_region>(*(ringBufferShm_ptr_.get()), read_write);
+    applyMemoryPolicy(ringBufferShmRegion_ptr_->get_address(), ringBufferShmRegion_ptr_->get_size());
+    ringBuffer_raw_ptr_ = reinterpret_cast<ringBufferType*>(ringBufferShmRegion_ptr_->get_address());
+    formatRingBuffer(ringDepth, isCreator);
   }
 
-  bool shmIndexRingBuffer::moveStartIndex(ringBufferIndexBlockType &indexBlock)
+  uint64_t shmIndexRingBuffer::calculateRingBufferSize(uint32_t ringDepth)
   {
-    BI::scoped_lock<BI::interprocess_sharable_mutex>    startIndexLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-
-    if (ringBuffer_raw_ptr_->startIndex_ == SHM_INVALID_INDEX)
+    if (ringDepth == 0 || (ringDepth & (ringDepth - 1)) != 0)
     {
-      LOG_ERROR("Ring buffer is not append any content");
-      return PROCESS_FAIL;
+      throw std::runtime_error("dawn: ring buffer depth must be a power of two");
     }
-    else if (ringBuffer_raw_ptr_->startIndex_ == ringBuffer_raw_ptr_->endIndex_)
+    return SHM_INDEX_RING_BUFFER_HEAD_SIZE + static_cast<uint64_t>(SHM_INDEX_BLOCK_SIZE) * ringDepth;
+  }
+
+  void shmIndexRingBuffer::formatRingBuffer(uint32_t ringDepth, bool isCreator)
+  {
+    if (isCreator)
     {
-      /// @note Prevent to GCC 9.4.0 throw "cannot bind packed field" error.
-      LOG_WARN("Ring buffer start index {} overlap end index {}, ring buffer have not content", \
-        (ringBuffer_raw_ptr_->startIndex_ + 0), (ringBuffer_raw_ptr_->endIndex_ + 0));
-      return PROCESS_FAIL;
+      ringBuffer_raw_ptr_->totalIndex_ = ringDepth;
+      ringBuffer_raw_ptr_->indexMask_ = ringDepth - 1;
+      ringBuffer_raw_ptr_->segmentState_.store(SHM_SEGMENT_READY_FLAG, std::memory_order_release);
     }
-    else if (calculateIndex((ringBuffer_raw_ptr_->startIndex_ + 1)) == ringBuffer_raw_ptr_->endIndex_)
+    else
     {
-      LOG_WARN("Ring buffer start index {} will overlap end index {}", ringBuffer_raw_ptr_->startIndex_ + 1, (ringBuffer_raw_ptr_->endIndex_ + 0));
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      ringBuffer_raw_ptr_->startIndex_ = calculateIndex(ringBuffer_raw_ptr_->startIndex_ + 1);
-      return PROCESS_SUCCESS;
+      waitSegmentCreator([this]() {
+        return ringBuffer_raw_ptr_->segmentState_.load(std::memory_order_acquire) == SHM_SEGMENT_READY_FLAG;
+      });
+      if (ringBuffer_raw_ptr_->totalIndex_ != ringDepth)
+      {
+        LOG_INFO("Ring buffer {} depth is {}, requested depth {} is ignored", shmIdentity_, ringBuffer_raw_ptr_->totalIndex_, ringDepth);
+      }
     }
-    else if (calculateIndex((ringBuffer_raw_ptr_->startIndex_ + 1)) != ringBuffer_raw_ptr_->endIndex_)
+    indexMask_ = ringBuffer_raw_ptr_->indexMask_;
+  }
+
+  uint32_t shmIndexRingBuffer::getRingDepth() const
+  {
+    return ringBuffer_raw_ptr_->totalIndex_;
+  }
+
+  bool shmIndexRingBuffer::moveStartIndex(ringBufferIndexBlockType &indexBlock)
+  {
+    auto startIndex = ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire);
+    for (;;)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      ringBuffer_raw_ptr_->startIndex_ = calculateIndex(ringBuffer_raw_ptr_->startIndex_ + 1);
-      return PROCESS_SUCCESS;
+      if (startIndex >= ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire))
+      {
+        LOG_WARN("Ring buffer start index {} overlap end index, ring buffer have not content", startIndex);
+        return PROCESS_FAIL;
+      }
+
+      /// @note Copy the block before moving start index. Once start index moves, publisher can overwrite the slot.
+      if (readSlot(startIndex, indexBlock) == PROCESS_SUCCESS && \
+        ringBuffer_raw_ptr_->startIndex_.compare_exchange_weak(startIndex, startIndex + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        return PROCESS_SUCCESS;
+      }
+      //Abandoned slot holds no message, step over it.
+      if (isSlotAbandoned(startIndex))
+      {
+        ringBuffer_raw_ptr_->startIndex_.compare_exchange_strong(startIndex, startIndex + 1, std::memory_order_acq_rel, std::memory_order_acquire);
+      }
+      startIndex = ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire);
     }
     return PROCESS_FAIL;
   }
 
-  shmIndexRingBuffer::PROCESS_RESULT shmIndexRingBuffer::moveEndIndex(ringBufferIndexBlockType &indexBlock, uint32_t &storePosition)
+  bool shmIndexRingBuffer::moveStartIndex(uint64_t startIndex, ringBufferIndexBlockType &indexBlock)
+  {
+    if (startIndex >= ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire) || \
+      readSlot(startIndex, indexBlock) == PROCESS_FAIL)
+    {
+      return PROCESS_FAIL;
+    }
+    return ringBuffer_raw_ptr_->startIndex_.compare_exchange_strong(startIndex, startIndex + 1, \
+      std::memory_order_acq_rel, std::memory_order_acquire) ? PROCESS_SUCCESS : PROCESS_FAIL;
+  }
+
+  shmIndexRingBuffer::PROCESS_RESULT shmIndexRingBuffer::moveEndIndex(ringBufferIndexBlockType &indexBlock, uint64_t &storePosition)
+  {
+    return moveEndIndex(&indexBlock, 1, storePosition);
+  }
+
+  shmIndexRingBuffer::PROCESS_RESULT shmIndexRingBuffer::moveEndIndex(ringBufferIndexBlockType *indexBlocks, uint32_t blockNum, uint64_t &firstPosition)
   {
-    BI::scoped_lock<BI::interprocess_sharable_mutex>    endIndexLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
+    if (blockNum == 0 || blockNum > ringBuffer_raw_ptr_->totalIndex_)
+    {
+      LOG_ERROR("Ring buffer can not hold {} blocks at once", blockNum);
+      return PROCESS_RESULT::FAIL;
+    }
+    for (uint32_t i = 0; i < blockNum; i++)
+    {
+      indexBlocks[i].sequence_ = SHM_INVALID_SEQUENCE;
+    }
+    auto timeStamp = getTimestamp();
 
-    /// @note Accurate time stamp must be get after locked.
-    indexBlock.timeStamp_ = getTimestamp();
+    auto claimIndex = ringBuffer_raw_ptr_->claimIndex_.load(std::memory_order_acquire);
+    do
+    {
+      if (claimIndex + blockNum - ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire) > ringBuffer_raw_ptr_->totalIndex_)
+      {
+        LOG_WARN("Ring buffer's full filled");
+        return PROCESS_RESULT::BUFFER_FILL;
+      }
+    } while (ringBuffer_raw_ptr_->claimIndex_.compare_exchange_weak(claimIndex, claimIndex + blockNum, std::memory_order_acq_rel, std::memory_order_acquire) == false);
 
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
+    uint32_t publishNum = 0;
+    for (uint32_t i = 0; i < blockNum; i++)
     {
-      // This scenario is ring buffer is initial.
-      ringBuffer_raw_ptr_->endIndex_ = 0;
-      ringBuffer_raw_ptr_->startIndex_ = 0;
-      std::memcpy(&ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->endIndex_], &indexBlock, sizeof(ringBufferIndexBlockType));
-      storePosition = ringBuffer_raw_ptr_->endIndex_;
-      ringBuffer_raw_ptr_->endIndex_ = calculateIndex(ringBuffer_raw_ptr_->endIndex_ + 1);
-      return PROCESS_RESULT::SUCCESS;
+      if (claimSlot(claimIndex + i) == PROCESS_FAIL)
+      {
+        continue;
+      }
+      indexBlocks[i].timeStamp_ = timeStamp;
+      auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(claimIndex + i)];
+      std::memcpy(slot.content_, &indexBlocks[i].timeStamp_, sizeof(slot.content_));
+      if (stampSlot(claimIndex + i) == PROCESS_SUCCESS)
+      {
+        indexBlocks[i].sequence_ = claimIndex + i;
+        publishNum++;
+      }
     }
-    else if (ringBuffer_raw_ptr_->startIndex_ == ringBuffer_raw_ptr_->endIndex_)
+
+    /// @note Readers only trust sequences below end index, so return after end index passes the claim.
+    commitEndIndex(claimIndex + blockNum);
+    firstPosition = claimIndex;
+    if (publishNum != blockNum)
     {
-      // This scenario is ring buffer is empty.
-      std::memcpy(&ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->endIndex_], &indexBlock, sizeof(ringBufferIndexBlockType));
-      storePosition = ringBuffer_raw_ptr_->endIndex_;
-      ringBuffer_raw_ptr_->endIndex_ = calculateIndex(ringBuffer_raw_ptr_->endIndex_ + 1);
-      return PROCESS_RESULT::SUCCESS;
+      LOG_ERROR("Ring buffer {} abandoned {} of {} blocks from {}, publisher stalled", shmIdentity_, \
+        blockNum - publishNum, blockNum, claimIndex);
+      return PROCESS_RESULT::FAIL;
     }
-    else if (calculateIndex(ringBuffer_raw_ptr_->endIndex_ + 1) == ringBuffer_raw_ptr_->startIndex_)
+    return PROCESS_RESULT::SUCCESS;
+  }
+
+  bool shmIndexRingBuffer::claimSlot(uint64_t index)
+  {
+    auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(index)];
+    auto word = slot.sequence_.load(std::memory_order_acquire);
+    do
     {
-      LOG_WARN("Ring buffer's full filled");
-      return PROCESS_RESULT::BUFFER_FILL;
+      //Slot is abandoned, or even taken by a later round.
+      if ((word & ~SLOT_FLAG_MASK) >= index + 1)
+      {
+        return PROCESS_FAIL;
+      }
+    } while (slot.sequence_.compare_exchange_weak(word, (index + 1) | SLOT_WRITING_FLAG, \
+      std::memory_order_acq_rel, std::memory_order_acquire) == false);
+    std::atomic_thread_fence(std::memory_order_release);
+    return PROCESS_SUCCESS;
+  }
+
+  bool shmIndexRingBuffer::stampSlot(uint64_t index)
+  {
+    auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(index)];
+    auto word = (index + 1) | SLOT_WRITING_FLAG;
+    return slot.sequence_.compare_exchange_strong(word, index + 1, std::memory_order_release, std::memory_order_relaxed) ? \
+      PROCESS_SUCCESS : PROCESS_FAIL;
+  }
+
+  void shmIndexRingBuffer::abandonSlot(uint64_t index)
+  {
+    auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(index)];
+    auto word = slot.sequence_.load(std::memory_order_acquire);
+    while (word != index + 1 && word != ((index + 1) | SLOT_ABANDONED_FLAG))
+    {
+      if (slot.sequence_.compare_exchange_weak(word, (index + 1) | SLOT_ABANDONED_FLAG, \
+        std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        LOG_ERROR("Ring buffer {} abandons sequence {}, its publisher stalls over {} us", shmIdentity_, index, \
+          SHM_RING_COMMIT_TIMEOUT_US);
+        return;
+      }
     }
-    else if (calculateIndex(ringBuffer_raw_ptr_->endIndex_ + 1) != ringBuffer_raw_ptr_->startIndex_)
+  }
+
+  bool shmIndexRingBuffer::isSlotAbandoned(uint64_t index)
+  {
+    auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(index)];
+    return slot.sequence_.load(std::memory_order_acquire) == ((index + 1) | SLOT_ABANDONED_FLAG);
+  }
+
+  void shmIndexRingBuffer::commitEndIndex(uint64_t commitIndex)
+  {
+    auto endIndex = ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire);
+    auto stallIndex = SHM_INVALID_SEQUENCE;
+    std::chrono::steady_clock::time_point deadline;
+    while (endIndex < commitIndex)
     {
-      std::memcpy(&ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->endIndex_], &indexBlock, sizeof(ringBufferIndexBlockType));
-      storePosition = ringBuffer_raw_ptr_->endIndex_;
-      ringBuffer_raw_ptr_->endIndex_ = calculateIndex(ringBuffer_raw_ptr_->endIndex_ + 1);
-      return PROCESS_RESULT::SUCCESS;
+      auto word = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(endIndex)].sequence_.load(std::memory_order_acquire);
+      if (word == endIndex + 1 || word == ((endIndex + 1) | SLOT_ABANDONED_FLAG))
+      {
+        //Slot is finished whoever claimed it, on failure endIndex is reloaded.
+        if (ringBuffer_raw_ptr_->endIndex_.compare_exchange_weak(endIndex, endIndex + 1, \
+          std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+          endIndex++;
+        }
+        continue;
+      }
+
+      if (stallIndex != endIndex)
+      {
+        stallIndex = endIndex;
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(SHM_RING_COMMIT_TIMEOUT_US);
+      }
+      else if (std::chrono::steady_clock::now() >= deadline)
+      {
+        abandonSlot(endIndex);
+        continue;
+      }
+      std::this_thread::yield();
+      endIndex = ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire);
     }
-    return PROCESS_RESULT::FAIL;
   }
 
   bool shmIndexRingBuffer::getStartBuffer(ringBufferIndexBlockType &indexBlock)
   {
-    uint32_t index;
+    uint64_t index;
     return getStartBuffer(indexBlock, index);
   }
 
-  bool shmIndexRingBuffer::getStartBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index)
+  bool shmIndexRingBuffer::getStartBuffer(ringBufferIndexBlockType &indexBlock, uint64_t &index)
+  {
+    return getStartIndex(index, indexBlock);
+  }
+
+  bool shmIndexRingBuffer::getLatestBuffer(ringBufferIndexBlockType &indexBlock)
+  {
+    uint64_t index;
+    return getLatestBuffer(indexBlock, index);
+  }
+
+  bool shmIndexRingBuffer::getLatestBuffer(ringBufferIndexBlockType &indexBlock, uint64_t &index)
+  {
+    auto endIndex = ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire);
+    if (endIndex == 0 || endIndex <= ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire))
+    {
+      return PROCESS_FAIL;
+    }
+
+    if (readSlot(endIndex - 1, indexBlock) == PROCESS_FAIL)
+    {
+      return PROCESS_FAIL;
+    }
+    index = endIndex - 1;
+    return PROCESS_SUCCESS;
+  }
+
+  bool shmIndexRingBuffer::getSpecificIndexBuffer(uint64_t index, ringBufferIndexBlockType &indexBlock)
   {
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX || ringBuffer_raw_ptr_->startIndex_ == SHM_INVALID_INDEX)
+    if (checkIndexValid(index) == false)
     {
       return PROCESS_FAIL;
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    return readSlot(index, indexBlock);
+  }
+
+  bool  shmIndexRingBuffer::getStartIndex(uint64_t &storeIndex, ringBufferIndexBlockType &indexBlock)
+  {
+    for (;;)
+    {
+      auto startIndex = ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire);
+      if (startIndex >= ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire))
+      {
+        return PROCESS_FAIL;
+      }
+
+      if (readSlot(startIndex, indexBlock) == PROCESS_SUCCESS)
+      {
+        storeIndex = startIndex;
+        return PROCESS_SUCCESS;
+      }
+      if (isSlotAbandoned(startIndex))
+      {
+        ringBuffer_raw_ptr_->startIndex_.compare_exchange_strong(startIndex, startIndex + 1, std::memory_order_acq_rel, std::memory_order_acquire);
+      }
+      //Start index is recycled while reading, try the new start index.
+    }
+    return PROCESS_FAIL;
+  }
+
+  uint64_t shmIndexRingBuffer::getEndIndex()
+  {
+    return ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire);
+  }
+
+  uint32_t shmIndexRingBuffer::registerReader()
+  {
+    for (uint32_t readerId = 0; readerId < SHM_READER_MAX_NUM; readerId++)
+    {
+      auto &reader = ringBuffer_raw_ptr_->readerCursor_[readerId];
+      uint32_t state = READER_FREE;
+      if (reader.state_.compare_exchange_strong(state, READER_BUSY, std::memory_order_acq_rel))
+      {
+        reader.pid_.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+        reader.cursor_.store(ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire), std::memory_order_relaxed);
+        reader.state_.store(READER_ACTIVE, std::memory_order_seq_cst);
+        auto readerSlotNum = ringBuffer_raw_ptr_->readerSlotNum_.load(std::memory_order_acquire);
+        while (readerSlotNum <= readerId && \
+          ringBuffer_raw_ptr_->readerSlotNum_.compare_exchange_weak(readerSlotNum, readerId + 1, std::memory_order_acq_rel) == false)
+        {
+        }
+        return readerId;
+      }
+    }
+    LOG_WARN("Ring buffer {} reader registry is full, reader isn't protected from recycling", shmIdentity_);
+    return SHM_INVALID_INDEX;
+  }
+
+  void shmIndexRingBuffer::unregisterReader(uint32_t readerId)
+  {
+    if (readerId < SHM_READER_MAX_NUM)
+    {
+      ringBuffer_raw_ptr_->readerCursor_[readerId].pid_.store(0, std::memory_order_relaxed);
+      ringBuffer_raw_ptr_->readerCursor_[readerId].state_.store(READER_FREE, std::memory_order_release);
+    }
+  }
+
+  void shmIndexRingBuffer::updateReaderCursor(uint32_t readerId, uint64_t cursor)
+  {
+    if (readerId < SHM_READER_MAX_NUM && cursor != SHM_INVALID_SEQUENCE)
+    {
+      ringBuffer_raw_ptr_->readerCursor_[readerId].cursor_.store(cursor, std::memory_order_release);
+    }
+  }
+
+  bool shmIndexRingBuffer::reviveReader(uint32_t readerId)
+  {
+    if (readerId >= SHM_READER_MAX_NUM)
+    {
+      return false;
+    }
+    auto &reader = ringBuffer_raw_ptr_->readerCursor_[readerId];
+    uint32_t state = READER_EVICTED;
+    if (reader.state_.load(std::memory_order_relaxed) != READER_EVICTED || \
+      reader.state_.compare_exchange_strong(state, READER_BUSY, std::memory_order_acq_rel) == false)
+    {
+      return false;
+    }
+    reader.cursor_.store(ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    reader.state_.store(READER_ACTIVE, std::memory_order_seq_cst);
+    return true;
+  }
+
+  uint64_t shmIndexRingBuffer::getMinReaderCursor()
+  {
+    auto minCursor = SHM_INVALID_SEQUENCE;
+    auto readerSlotNum = std::min(ringBuffer_raw_ptr_->readerSlotNum_.load(std::memory_order_acquire), SHM_READER_MAX_NUM);
+    for (uint32_t readerId = 0; readerId < readerSlotNum; readerId++)
+    {
+      auto &reader = ringBuffer_raw_ptr_->readerCursor_[readerId];
+      auto state = reader.state_.load(std::memory_order_seq_cst);
+      if ((state != READER_BUSY && state != READER_ACTIVE) || releaseDeadReader(readerId))
+      {
+        continue;
+      }
+      if (state == READER_BUSY)
+      {
+        //Reader is taking start index as its cursor.
+        minCursor = std::min(minCursor, ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire));
+        continue;
+      }
+      minCursor = std::min(minCursor, reader.cursor_.load(std::memory_order_acquire));
+    }
+    return minCursor;
+  }
+
+  bool shmIndexRingBuffer::evictSlowestReader()
+  {
+    auto readerSlotNum = std::min(ringBuffer_raw_ptr_->readerSlotNum_.load(std::memory_order_acquire), SHM_READER_MAX_NUM);
+    auto slowestId = SHM_INVALID_INDEX;
+    auto minCursor = SHM_INVALID_SEQUENCE;
+    for (uint32_t readerId = 0; readerId < readerSlotNum; readerId++)
+    {
+      auto &reader = ringBuffer_raw_ptr_->readerCursor_[readerId];
+      auto cursor = reader.cursor_.load(std::memory_order_acquire);
+      if (reader.state_.load(std::memory_order_acquire) == READER_ACTIVE && cursor < minCursor)
+      {
+        minCursor = cursor;
+        slowestId = readerId;
+      }
+    }
+    if (slowestId == SHM_INVALID_INDEX || minCursor > ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire))
+    {
+      return PROCESS_FAIL;
+    }
+    uint32_t state = READER_ACTIVE;
+    if (ringBuffer_raw_ptr_->readerCursor_[slowestId].state_.compare_exchange_strong(state, READER_EVICTED, std::memory_order_acq_rel) == false)
+    {
+      return PROCESS_FAIL;
+    }
+    LOG_WARN("Reader {} of ring buffer {} is evicted at {}", slowestId, shmIdentity_, minCursor);
+    return PROCESS_SUCCESS;
+  }
+
+  bool shmIndexRingBuffer::releaseDeadReader(uint32_t readerId)
+  {
+    auto &reader = ringBuffer_raw_ptr_->readerCursor_[readerId];
+    auto pid = reader.pid_.load(std::memory_order_relaxed);
+    if (pid == 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH)
+    {
+      return false;
+    }
+    //Only the publisher which clears pid releases slot, a new reader may take it right after.
+    if (reader.pid_.compare_exchange_strong(pid, 0, std::memory_order_acq_rel) == false)
+    {
+      return false;
+    }
+    LOG_WARN("Reader {} of ring buffer {} is dead, release its cursor", readerId, shmIdentity_);
+    auto state = reader.state_.load(std::memory_order_acquire);
+    while (state != READER_FREE && \
+      reader.state_.compare_exchange_weak(state, READER_FREE, std::memory_order_acq_rel, std::memory_order_acquire) == false)
+    {
+    }
+    return true;
+  }
+
+  bool shmIndexRingBuffer::checkIndexValid(uint64_t index)
+  {
+    if (index == SHM_INVALID_SEQUENCE)
+    {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ringBuffer_raw_ptr_->startIndex_.load(std::memory_order_acquire) <= index && \
+      index < ringBuffer_raw_ptr_->endIndex_.load(std::memory_order_acquire);
+  }
+
+  uint32_t shmIndexRingBuffer::calculateIndex(uint64_t ringBufferIndex)
+  {
+    return static_cast<uint32_t>(ringBufferIndex & indexMask_);
+  }
+
+  bool shmIndexRingBuffer::readSlot(uint64_t index, ringBufferIndexBlockType &indexBlock)
+  {
+    auto &slot = ringBuffer_raw_ptr_->ringBufferSlot_[calculateIndex(index)];
+    if (slot.sequence_.load(std::memory_order_acquire) != index + 1)
+    {
+      return PROCESS_FAIL;
+    }
+    std::memcpy(&indexBlock.timeStamp_, slot.content_, sizeof(slot.content_));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence_.load(std::memory_order_relaxed) != index + 1)
+    {
+      return PROCESS_FAIL;
+    }
+    indexBlock.sequence_ = index;
+    return PROCESS_SUCCESS;
+  }
+
+  /// @brief Mask of blockNum bits starting from bit position.
+  static inline uint64_t getBitmapMask(uint32_t position, uint32_t blockNum)
+  {
+    return ((blockNum >= 64) ? ~0ULL : ((1ULL << blockNum) - 1)) << position;
+  }
+
+  /// @brief Bit p of result is set when bits p ... p + blockNum - 1 of word are all set.
+  static inline uint64_t findBitmapRun(uint64_t word, uint32_t blockNum)
+  {
+    for (uint32_t len = 1; len < blockNum && word != 0;)
+    {
+      auto shift = std::min(len, blockNum - len);
+      word &= (word >> shift);
+      len += shift;
+    }
+    return word;
+  }
+
+  shmMsgPool::shmMsgPool(std::string_view identity, uint32_t blockContentSize, uint32_t blockNum):
+    identity_(identity),
+    mechanismIdentity_(MECHANISM_PREFIX + identity_),
+    blockContentSize_(blockContentSize),
+    blockSize_(blockContentSize + SHM_BLOCK_HEAD_SIZE),
+    blockNum_(blockNum),
+    bitmapWordNum_((blockNum + 63) / 64)
+  {
+    using namespace BI;
+    auto poolSize = calculatePoolLayout(blockContentSize, blockNum).poolSize_;
+
+    ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(mechanismIdentity_);
+    msgBufferShm_ptr_ = std::make_shared<shared_memory_object>(open_or_create, identity_.c_str(), read_write);
+
+    ///@note Only the creator sizes the pool and marks all blocks free.
+    ///      Attachers map the size chosen by the creator, then adopt geometry from the pool head.
+    bool isCreator = ipc_ptr_->mechanism_raw_ptr_->msgPoolInitialFlag_.try_wait();
+    if (isCreator)
+    {
+      msgBufferShm_ptr_->truncate(poolSize);
+    }
+    else
+    {
+      waitSegmentCreator([this]() {
+        offset_t currentSize = 0;
+        return msgBufferShm_ptr_->get_size(currentSize) && currentSize > 0;
+      });
+    }
+    msgBufferShmRegion_ptr_ = std::make_shared<mapped_region>(*(msgBufferShm_ptr_.get()), read_write);
+    applyMemoryPolicy(msgBufferShmRegion_ptr_->get_address(), msgBufferShmRegion_ptr_->get_size());
+    poolHead_raw_ptr_ = reinterpret_cast<poolHeadType*>(msgBufferShmRegion_ptr_->get_address());
+    formatPool(msgBufferShmRegion_ptr_->get_size(), isCreator);
+  }
+
+  shmMsgPool::shmMsgPool(std::string_view identity, std::shared_ptr<BI::mapped_region> region_ptr, uint64_t offset, uint64_t poolSize, \
+    uint32_t blockContentSize, uint32_t blockNum, bool isCreator):
+    msgBufferShmRegion_ptr_(region_ptr),
+    identity_(identity),
+    blockContentSize_(blockContentSize),
+    blockSize_(blockContentSize + SHM_BLOCK_HEAD_SIZE),
+    blockNum_(blockNum),
+    bitmapWordNum_((blockNum + 63) / 64)
+  {
+    poolHead_raw_ptr_ = reinterpret_cast<poolHeadType*>(reinterpret_cast<char*>(msgBufferShmRegion_ptr_->get_address()) + offset);
+    formatPool(poolSize, isCreator);
+  }
+
+  std::shared_ptr<shmMsgPool> shmMsgPool::getGlobalPool()
+  {
+    static std::mutex globalPoolMutex;
+    static std::weak_ptr<shmMsgPool> globalPool_weak_ptr;
+    std::lock_guard lock(globalPoolMutex);
+    auto globalPool_ptr = globalPool_weak_ptr.lock();
+    if (globalPool_ptr == nullptr)
+    {
+      globalPool_ptr = std::make_shared<shmMsgPool>();
+      globalPool_weak_ptr = globalPool_ptr;
+    }
+    return globalPool_ptr;
+  }
+
+  void shmMsgPool::formatPool(uint64_t poolSize, bool isCreator)
+  {
+    if (isCreator)
+    {
+      poolHead_raw_ptr_->blockContentSize_ = blockContentSize_;
+      poolHead_raw_ptr_->blockNum_ = blockNum_;
+      poolHead_raw_ptr_->version_ = SHM_POOL_SEGMENT_VERSION;
+      poolHead_raw_ptr_->spaceWaiterNum_.store(0, std::memory_order_relaxed);
+    }
+    else
+    {
+      waitSegmentCreator([this]() {
+        return poolHead_raw_ptr_->segmentState_.load(std::memory_order_acquire) == SHM_SEGMENT_READY_FLAG;
+      });
+      if (poolHead_raw_ptr_->version_ != SHM_POOL_SEGMENT_VERSION)
+      {
+        LOG_ERROR("Shm pool {} has layout version {} instead of {}, it is left by another build and must be removed", \
+          identity_, poolHead_raw_ptr_->version_, SHM_POOL_SEGMENT_VERSION);
+        throw std::runtime_error("dawn: shm pool version is mismatched");
+      }
+      if (blockNum_ != 0 && (poolHead_raw_ptr_->blockContentSize_ != blockContentSize_ || poolHead_raw_ptr_->blockNum_ != blockNum_))
+      {
+        LOG_INFO("Shm pool {} geometry is {}x{}, requested geometry is ignored", identity_, \
+          poolHead_raw_ptr_->blockContentSize_, poolHead_raw_ptr_->blockNum_);
+      }
+      blockContentSize_ = poolHead_raw_ptr_->blockContentSize_;
+      blockSize_ = blockContentSize_ + SHM_BLOCK_HEAD_SIZE;
+      blockNum_ = poolHead_raw_ptr_->blockNum_;
+      bitmapWordNum_ = (blockNum_ + 63) / 64;
+    }
+
+    auto layout = calculatePoolLayout(blockContentSize_, blockNum_);
+    if (layout.poolSize_ > poolSize)
+    {
+      LOG_ERROR("Shm pool {} of {} bytes can not hold {}x{} blocks, remove it if it is left by another build", \
+        identity_, poolSize, blockContentSize_, blockNum_);
+      throw std::runtime_error("dawn: shm pool geometry is mismatched");
+    }
+    auto poolAddr = reinterpret_cast<char*>(poolHead_raw_ptr_);
+    usedBitmap_raw_ptr_ = reinterpret_cast<std::atomic<uint64_t>*>(poolAddr + layout.bitmapOffset_);
+    pinCount_raw_ptr_ = reinterpret_cast<std::atomic<uint32_t>*>(poolAddr + layout.pinCountOffset_);
+    msgBuffer_raw_ptr_ = reinterpret_cast<void*>(poolAddr + layout.blockOffset_);
+    //Free channel keeps the region mapped, so it stays valid for waiters outliving the pool handle.
+    auto freeChannelOffset = reinterpret_cast<char*>(&poolHead_raw_ptr_->freeChannel_) - \
+      reinterpret_cast<char*>(msgBufferShmRegion_ptr_->get_address());
+    freeChannel_ptr_ = std::make_shared<shmChannel>(identity_, msgBufferShmRegion_ptr_, freeChannelOffset);
+
+    ///@note Zero filled bitmap already marks every block free, only bits past the last block are marked used.
+    if (isCreator)
+    {
+      if (blockNum_ % 64 != 0)
+      {
+        usedBitmap_raw_ptr_[bitmapWordNum_ - 1].store(~getBitmapMask(0, blockNum_ % 64), std::memory_order_relaxed);
+      }
+      poolHead_raw_ptr_->freeBlockNum_.store(blockNum_, std::memory_order_relaxed);
+      poolHead_raw_ptr_->segmentState_.store(SHM_SEGMENT_READY_FLAG, std::memory_order_release);
+    }
+  }
+
+  shmMsgPool::poolLayoutType shmMsgPool::calculatePoolLayout(uint32_t blockContentSize, uint32_t blockNum)
+  {
+    if (blockContentSize == 0 || blockContentSize % 8 != 0 || blockNum == 0 || blockNum == SHM_INVALID_INDEX)
+    {
+      throw std::runtime_error("dawn: invalid shm pool geometry");
+    }
+    poolLayoutType layout;
+    layout.bitmapOffset_ = alignCacheLine(sizeof(poolHeadType));
+    layout.pinCountOffset_ = layout.bitmapOffset_ + alignCacheLine((blockNum + 63) / 64 * sizeof(uint64_t));
+    layout.blockOffset_ = layout.pinCountOffset_ + alignCacheLine(blockNum * sizeof(uint32_t));
+    layout.poolSize_ = layout.blockOffset_ + static_cast<uint64_t>(blockNum) * (blockContentSize + SHM_BLOCK_HEAD_SIZE);
+    return layout;
+  }
+
+  shmMsgPool::ALLOC_RESULT shmMsgPool::requireMsgShm(uint32_t data_size, std::vector<uint32_t> &indexVec)
+  {
+    assert(data_size != 0 && " require zero shm size");
+    indexVec.clear();
+    uint32_t needBlockNum = calculateExtentBlockNum(data_size);
+    if (needBlockNum > blockNum_)
+    {
+      return ALLOC_RESULT::TOO_LARGE;
+    }
+    uint32_t claimedBlockNum = 0;
+
+    auto index = claimExtent(needBlockNum, needBlockNum, claimedBlockNum);
+    if (index != SHM_INVALID_INDEX)
+    {
+      initializeExtent(index, claimedBlockNum);
+      indexVec.emplace_back(index);
+      return ALLOC_RESULT::SUCCESS;
+    }
+
+    //Pool is fragmented, fall back to a chain of shorter extents.
+    msgType   *prev_msg = nullptr;
+    for (uint32_t remainLen = data_size; remainLen != 0;)
+    {
+      uint32_t wantBlockNum = std::min(calculateExtentBlockNum(remainLen), 64U);
+      index = claimExtent(wantBlockNum, 1, claimedBlockNum);
+      if (index == SHM_INVALID_INDEX)
+      {
+        if (indexVec.empty() == false)
+        {
+          recycleMsgChain(indexVec.front());
+          indexVec.clear();
+        }
+        return ALLOC_RESULT::NO_SPACE;
+      }
+
+      auto msgIns = initializeExtent(index, claimedBlockNum);
+      if (prev_msg != nullptr)
+      {
+        prev_msg->next_ = index;
+      }
+      prev_msg = msgIns;
+      indexVec.emplace_back(index);
+      remainLen -= std::min(remainLen, getExtentContentSize(claimedBlockNum));
+    }
+
+    return ALLOC_RESULT::SUCCESS;
+  }
+
+  std::vector<uint32_t> shmMsgPool::requireMsgShmBatch(const std::vector<uint32_t> &dataSizeVec)
+  {
+    std::vector<uint32_t>   indexVec;
+    uint64_t totalBlockNum = 0;
+    for (auto dataSize : dataSizeVec)
+    {
+      assert(dataSize != 0 && " require zero shm size");
+      totalBlockNum += calculateExtentBlockNum(dataSize);
+    }
+    if (totalBlockNum == 0 || totalBlockNum > blockNum_)
+    {
+      return indexVec;
+    }
+
+    uint32_t claimedBlockNum = 0;
+    auto index = claimExtent(totalBlockNum, totalBlockNum, claimedBlockNum);
+    if (index == SHM_INVALID_INDEX)
+    {
+      return indexVec;
+    }
+
+    //Cut the run into one extent per message.
+    indexVec.reserve(dataSizeVec.size());
+    for (auto dataSize : dataSizeVec)
+    {
+      auto extentBlockNum = calculateExtentBlockNum(dataSize);
+      initializeExtent(index, extentBlockNum);
+      indexVec.emplace_back(index);
+      index += extentBlockNum;
+    }
+    return indexVec;
+  }
+
+  uint32_t shmMsgPool::requireOneBlock()
+  {
+    uint32_t claimedBlockNum = 0;
+    auto index = claimExtent(1, 1, claimedBlockNum);
+    if (index == SHM_INVALID_INDEX)
+    {
+      return SHM_INVALID_INDEX;
+    }
+    initializeExtent(index, claimedBlockNum);
+    return index;
+  }
+
+  void* shmMsgPool::getMsgRawBuffer()
+  {
+    return msgBuffer_raw_ptr_;
+  }
+
+  msgType* shmMsgPool::getMsgBlock(uint32_t index)
+  {
+    return reinterpret_cast<msgType*>(FIND_SHARE_MEM_BLOCK_ADDR(msgBuffer_raw_ptr_, index, blockSize_));
+  }
+
+  uint32_t shmMsgPool::getBlockContentSize() const
+  {
+    return blockContentSize_;
+  }
+
+  uint32_t shmMsgPool::getBlockNum() const
+  {
+    return blockNum_;
+  }
+
+  uint32_t shmMsgPool::getExtentContentSize(uint32_t blockNum) const
+  {
+    return blockNum * blockSize_ - SHM_BLOCK_HEAD_SIZE;
+  }
+
+  uint32_t shmMsgPool::calculateExtentBlockNum(uint32_t data_size) const
+  {
+    return static_cast<uint32_t>((static_cast<uint64_t>(data_size) + SHM_BLOCK_HEAD_SIZE + blockSize_ - 1) / blockSize_);
+  }
+
+  uint32_t shmMsgPool::getFreeBlockNum()
+  {
+    return poolHead_raw_ptr_->freeBlockNum_.load(std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<shmChannel> shmMsgPool::getFreeChannel() const
+  {
+    return freeChannel_ptr_;
+  }
+
+  void shmMsgPool::addSpaceWaiter()
+  {
+    poolHead_raw_ptr_->spaceWaiterNum_.fetch_add(1, std::memory_order_seq_cst);
+    //pairs with releaseExtent, bitmap loads of the next try can't move before registration.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void shmMsgPool::removeSpaceWaiter()
+  {
+    poolHead_raw_ptr_->spaceWaiterNum_.fetch_sub(1, std::memory_order_release);
+  }
+
+  bool shmMsgPool::recycleMsgShm(uint32_t index)
+  {
+    assert(index < (blockNum_) && "msg shm index is out of range");
+
+    auto msgIns = getMsgBlock(index);
+    auto blockNum = std::min(std::max(msgIns->blockNum_, 1U), blockNum_ - index);
+
+#ifdef DAWN_SHM_DEBUG_SCRUB
+    std::memset(&msgIns->content_, SHM_DEBUG_SCRUB_BYTE, getExtentContentSize(blockNum));
+#endif
+    releaseExtent(index, blockNum);
+    return true;
+  }
+
+  bool shmMsgPool::recycleMsgChain(uint32_t headIndex)
+  {
+    assert(headIndex < blockNum_ && "msg shm index is out of range");
+    for (auto msgIndex = headIndex; msgIndex < blockNum_;)
+    {
+      auto msgBlockIns = getMsgBlock(msgIndex);
+      auto nextIndex = msgBlockIns->next_;
+      recycleMsgShm(msgIndex);
+      msgIndex = nextIndex;
+    }
+    return PROCESS_SUCCESS;
+  }
+
+  uint32_t shmMsgPool::claimExtent(uint32_t blockNum, uint32_t minBlockNum, uint32_t &claimedBlockNum)
+  {
+    auto usedBitmap = usedBitmap_raw_ptr_;
+    auto hint = poolHead_raw_ptr_->allocHint_.load(std::memory_order_relaxed) % bitmapWordNum_;
+    claimedBlockNum = 0;
+
+    if (blockNum <= 64)
+    {
+      for (uint32_t i = 0; i < bitmapWordNum_; i++)
+      {
+        auto wordIndex = (hint + i) % bitmapWordNum_;
+        auto usedWord = usedBitmap[wordIndex].load(std::memory_order_relaxed);
+        for (auto word = ~usedWord; word != 0; word = ~usedWord)
+        {
+          uint32_t position = 0;
+          uint32_t runBlockNum = blockNum;
+          auto run = findBitmapRun(word, blockNum);
+          if (run != 0)
+          {
+            position = getBottomBitPosition(run);
+          }
+          else if (minBlockNum < blockNum)
+          {
+            //Take the lowest run of this word, it is shorter than wanted.
+            position = getBottomBitPosition(word);
+            auto freeBits = word >> position;
+            runBlockNum = (~freeBits == 0) ? 64 : getBottomBitPosition(~freeBits);
+            runBlockNum = std::min(runBlockNum, blockNum);
+            if (runBlockNum < minBlockNum)
+            {
+              break;
+            }
+          }
+          else
+          {
+            break;
+          }
+
+          auto mask = getBitmapMask(position, runBlockNum);
+          if (usedBitmap[wordIndex].compare_exchange_weak(usedWord, usedWord | mask, std::memory_order_acquire, std::memory_order_relaxed))
+          {
+            poolHead_raw_ptr_->freeBlockNum_.fetch_sub(runBlockNum, std::memory_order_relaxed);
+            poolHead_raw_ptr_->allocHint_.store(wordIndex, std::memory_order_relaxed);
+            claimedBlockNum = runBlockNum;
+            return wordIndex * 64 + position;
+          }
+        }
+      }
+      return SHM_INVALID_INDEX;
+    }
+
+    //Long run starts at a word boundary, it owns whole words and the low bits of the word after them.
+    uint32_t fullWordNum = blockNum / 64;
+    uint64_t tailMask = getBitmapMask(0, blockNum % 64);
+    for (uint32_t i = 0; i < bitmapWordNum_; i++)
+    {
+      auto wordIndex = (hint + i) % bitmapWordNum_;
+      auto endWordIndex = wordIndex + fullWordNum;
+      if (endWordIndex > bitmapWordNum_ || (tailMask != 0 && endWordIndex >= bitmapWordNum_))
+      {
+        continue;
+      }
+
+      uint32_t claimedWordNum = 0;
+      for (; claimedWordNum < fullWordNum; claimedWordNum++)
+      {
+        uint64_t usedWord = 0;
+        if (usedBitmap[wordIndex + claimedWordNum].compare_exchange_strong(usedWord, ~0ULL, std::memory_order_acquire, std::memory_order_relaxed) == false)
+        {
+          break;
+        }
+      }
+
+      bool claimed = (claimedWordNum == fullWordNum);
+      if (claimed && tailMask != 0)
+      {
+        auto usedWord = usedBitmap[endWordIndex].load(std::memory_order_relaxed);
+        claimed = false;
+        while ((usedWord & tailMask) == 0)
+        {
+          if (usedBitmap[endWordIndex].compare_exchange_weak(usedWord, usedWord | tailMask, std::memory_order_acquire, std::memory_order_relaxed))
+          {
+            claimed = true;
+            break;
+          }
+        }
+      }
+
+      if (claimed)
+      {
+        poolHead_raw_ptr_->freeBlockNum_.fetch_sub(blockNum, std::memory_order_relaxed);
+        poolHead_raw_ptr_->allocHint_.store(endWordIndex, std::memory_order_relaxed);
+        claimedBlockNum = blockNum;
+        return wordIndex * 64;
+      }
+
+      //Roll back words claimed in this round.
+      for (uint32_t j = 0; j < claimedWordNum; j++)
+      {
+        usedBitmap[wordIndex + j].store(0, std::memory_order_release);
+      }
+    }
+    return SHM_INVALID_INDEX;
+  }
+
+  void shmMsgPool::releaseExtent(uint32_t index, uint32_t blockNum)
+  {
+    assert(index + blockNum <= blockNum_ && "msg shm extent is out of range");
+    for (uint32_t position = index, remainBlockNum = blockNum; remainBlockNum != 0;)
+    {
+      auto bitPosition = position % 64;
+      auto runBlockNum = std::min(remainBlockNum, 64 - bitPosition);
+      //seq_cst costs nothing more than release for a locked RMW, and it pairs with addSpaceWaiter.
+      usedBitmap_raw_ptr_[position / 64].fetch_and(~getBitmapMask(bitPosition, runBlockNum), std::memory_order_seq_cst);
+      position += runBlockNum;
+      remainBlockNum -= runBlockNum;
+    }
+    poolHead_raw_ptr_->freeBlockNum_.fetch_add(blockNum, std::memory_order_relaxed);
+    //Nobody waits for space by default, so release doesn't touch the shared free channel then.
+    if (poolHead_raw_ptr_->spaceWaiterNum_.load(std::memory_order_seq_cst) != 0)
+    {
+      freeChannel_ptr_->notifyAll();
+    }
+  }
+
+  msgType* shmMsgPool::initializeExtent(uint32_t index, uint32_t blockNum)
+  {
+    auto msgIns = new(FIND_SHARE_MEM_BLOCK_ADDR(msgBuffer_raw_ptr_, index, blockSize_)) msgType;
+    msgIns->blockNum_ = blockNum;
+    //keep pin count of late readers.
+    pinCount_raw_ptr_[index].fetch_and(MSG_PIN_COUNT_MASK, std::memory_order_acq_rel);
+    return msgIns;
+  }
+
+  bool shmMsgPool::pinMsgShm(uint32_t headIndex)
+  {
+    if (headIndex >= blockNum_)
+    {
+      return PROCESS_FAIL;
+    }
+    auto &pinWord = pinCount_raw_ptr_[headIndex];
+    auto pinCount = pinWord.fetch_add(1, std::memory_order_seq_cst);
+    if ((pinCount & (MSG_PIN_RETIRED_FLAG | MSG_PIN_FREED_FLAG)) != 0)
+    {
+      unpinMsgShm(headIndex);
+      return PROCESS_FAIL;
+    }
+    return PROCESS_SUCCESS;
+  }
+
+  void shmMsgPool::unpinMsgShm(uint32_t headIndex)
+  {
+    assert(headIndex < blockNum_ && "msg shm index is out of range");
+    auto &pinWord = pinCount_raw_ptr_[headIndex];
+    auto pinCount = pinWord.fetch_sub(1, std::memory_order_acq_rel);
+    if ((pinCount & MSG_PIN_COUNT_MASK) != 1 || (pinCount & MSG_PIN_RETIRED_FLAG) == 0)
+    {
+      return;
+    }
+
+    /// @note Only one of the last reader and the retirer wins the freed flag.
+    uint32_t expected = MSG_PIN_RETIRED_FLAG;
+    if (pinWord.compare_exchange_strong(expected, MSG_PIN_RETIRED_FLAG | MSG_PIN_FREED_FLAG, std::memory_order_acq_rel))
+    {
+      recycleMsgChain(headIndex);
+    }
+  }
+
+  void shmMsgPool::retireMsgShm(uint32_t headIndex)
+  {
+    assert(headIndex < blockNum_ && "msg shm index is out of range");
+    auto &pinWord = pinCount_raw_ptr_[headIndex];
+    pinWord.fetch_or(MSG_PIN_RETIRED_FLAG, std::memory_order_seq_cst);
+
+    uint32_t expected = MSG_PIN_RETIRED_FLAG;
+    if (pinWord.compare_exchange_strong(expected, MSG_PIN_RETIRED_FLAG | MSG_PIN_FREED_FLAG, std::memory_order_acq_rel))
+    {
+      recycleMsgChain(headIndex);
+    }
+    else
+    {
+      LOG_DEBUG("message {} is still borrowed, recycle it until the last reader leaves", headIndex);
+    }
+  }
+
+  shmTopicSegment::shmTopicSegment(std::string_view identity, const qosCfg &config):
+    identity_(TOPIC_PREFIX + std::string(identity))
+  {
+    using namespace BI;
+    auto ringDepth = config.ringDepth_ == 0 ? SHM_RING_BUFFER_DEPTH : config.ringDepth_;
+
+    /// @note Pools are sorted by block size, pool index in ring buffer depends on this order.
+    auto shmPoolCfgVec = config.shmPoolCfgVec_;
+    std::sort(shmPoolCfgVec.begin(), shmPoolCfgVec.end(), [](const qosCfg::shmPoolCfg &a, const qosCfg::shmPoolCfg &b) {
+      return a.blockContentSize_ < b.blockContentSize_;
+    });
+    auto duplicateIt = std::unique(shmPoolCfgVec.begin(), shmPoolCfgVec.end(), [](const qosCfg::shmPoolCfg &a, const qosCfg::shmPoolCfg &b) {
+      return a.blockContentSize_ == b.blockContentSize_;
+    });
+    if (duplicateIt != shmPoolCfgVec.end())
+    {
+      LOG_WARN("size class pools of topic {} are configured twice", identity);
+      shmPoolCfgVec.erase(duplicateIt, shmPoolCfgVec.end());
+    }
+
+    ///@note Exclusive create elects the creator, so the segment needs no separate initialization flag.
+    bool isCreator = true;
+    segmentLayoutType layout{};
+    try
+    {
+      layout = calculateSegmentLayout(ringDepth, shmPoolCfgVec);
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(create_only, identity_.c_str(), read_write);
+      segmentShm_ptr_->truncate(layout.segmentSize_);
+    }
+    catch (const interprocess_exception &e)
+    {
+      if (e.get_error_code() != already_exists_error)
+      {
+        throw;
+      }
+      isCreator = false;
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(open_only, identity_.c_str(), read_write);
+      waitSegmentCreator([this]() {
+        offset_t currentSize = 0;
+        return segmentShm_ptr_->get_size(currentSize) && currentSize > 0;
+      });
+    }
+    segmentShmRegion_ptr_ = std::make_shared<mapped_region>(*(segmentShm_ptr_.get()), read_write);
+    applyMemoryPolicy(segmentShmRegion_ptr_->get_address(), segmentShmRegion_ptr_->get_size());
+    segmentHead_raw_ptr_ = reinterpret_cast<segmentHeadType*>(segmentShmRegion_ptr_->get_address());
+
+    if (isCreator)
+    {
+      segmentHead_raw_ptr_->version_ = SHM_TOPIC_SEGMENT_VERSION;
+      segmentHead_raw_ptr_->layout_ = layout;
+      new(reinterpret_cast<char*>(segmentHead_raw_ptr_) + layout.channelOffset_) shmChannel::IPC_t;
+    }
+    else
+    {
+      waitSegmentCreator([this]() {
+        return segmentHead_raw_ptr_->segmentState_.load(std::memory_order_acquire) == SHM_SEGMENT_READY_FLAG;
+      });
+      if (segmentHead_raw_ptr_->version_ != SHM_TOPIC_SEGMENT_VERSION)
+      {
+        throw std::runtime_error("dawn: shm topic segment version is mismatched");
+      }
+      layout = segmentHead_raw_ptr_->layout_;
+      if (layout.segmentSize_ > segmentShmRegion_ptr_->get_size() || layout.poolNum_ > SHM_TOPIC_POOL_MAX_NUM)
+      {
+        throw std::runtime_error("dawn: shm topic segment layout is mismatched");
+      }
+    }
+
+    channel_ptr_ = std::make_shared<shmChannel>(identity_, segmentShmRegion_ptr_, layout.channelOffset_);
+    ringBuffer_ptr_ = std::make_shared<shmIndexRingBuffer>(identity_, segmentShmRegion_ptr_, layout.ringBufferOffset_, ringDepth, isCreator);
+    for (uint32_t i = 0; i < layout.poolNum_; i++)
+    {
+      auto poolCfg = (i < shmPoolCfgVec.size()) ? shmPoolCfgVec[i] : qosCfg::shmPoolCfg{0, 0};
+      shmPoolVec_.emplace_back(std::make_shared<shmMsgPool>(identity_ + "." + std::to_string(i), segmentShmRegion_ptr_, layout.poolOffset_[i], \
+        layout.poolOffset_[i + 1] - layout.poolOffset_[i], poolCfg.blockContentSize_, poolCfg.blockNum_, isCreator));
+    }
+
+    if (isCreator)
+    {
+      segmentHead_raw_ptr_->segmentState_.store(SHM_SEGMENT_READY_FLAG, std::memory_order_release);
+    }
+  }
+
+  shmTopicSegment::segmentLayoutType shmTopicSegment::calculateSegmentLayout(uint32_t ringDepth, const std::vector<qosCfg::shmPoolCfg> &shmPoolCfgVec)
+  {
+    if (shmPoolCfgVec.size() > SHM_TOPIC_POOL_MAX_NUM)
     {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
+      throw std::runtime_error("dawn: topic has too many size class pools");
     }
-    else
+    segmentLayoutType layout{};
+    layout.channelOffset_ = alignCacheLine(sizeof(segmentHeadType));
+    layout.ringBufferOffset_ = layout.channelOffset_ + alignCacheLine(sizeof(shmChannel::IPC_t));
+    layout.poolOffset_[0] = layout.ringBufferOffset_ + alignCacheLine(shmIndexRingBuffer::calculateRingBufferSize(ringDepth));
+    layout.poolNum_ = static_cast<uint32_t>(shmPoolCfgVec.size());
+    for (uint32_t i = 0; i < layout.poolNum_; i++)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      index = ringBuffer_raw_ptr_->startIndex_;
-      return PROCESS_SUCCESS;
+      auto poolSize = shmMsgPool::calculatePoolLayout(shmPoolCfgVec[i].blockContentSize_, shmPoolCfgVec[i].blockNum_).poolSize_;
+      layout.poolOffset_[i + 1] = layout.poolOffset_[i] + alignCacheLine(poolSize);
     }
-    return PROCESS_FAIL;
+    layout.segmentSize_ = layout.poolOffset_[layout.poolNum_];
+    return layout;
   }
 
-  bool shmIndexRingBuffer::getLatestBuffer(ringBufferIndexBlockType &indexBlock)
+  std::shared_ptr<shmChannel> shmTopicSegment::getChannel() const
   {
-    uint32_t index;
-    return getLatestBuffer(indexBlock, index);
+    return channel_ptr_;
   }
 
-  bool shmIndexRingBuffer::getLatestBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index)
+  std::shared_ptr<shmIndexRingBuffer> shmTopicSegment::getRingBuffer() const
   {
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
-    {
-      return PROCESS_FAIL;
-    }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
-    {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
-    }
-    else
-    {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[calculateLastIndex(ringBuffer_raw_ptr_->endIndex_)], sizeof(ringBufferIndexBlockType));
-      index = calculateLastIndex(ringBuffer_raw_ptr_->endIndex_);
-      return PROCESS_SUCCESS;
-    }
-    return PROCESS_FAIL;
+    return ringBuffer_ptr_;
+  }
+
+  const std::vector<std::shared_ptr<shmMsgPool>>& shmTopicSegment::getPoolVec() const
+  {
+    return shmPoolVec_;
   }
 
-  bool shmIndexRingBuffer::getSpecificIndexBuffer(uint32_t index, ringBufferIndexBlockType &indexBlock)
+  bool shmTopicSegment::remove(std::string_view identity)
   {
-    if (checkIndexValid(index) == PROCESS_FAIL)
+    auto segmentIdentity = TOPIC_PREFIX + std::string(identity);
+    try
     {
-      return PROCESS_FAIL;
+      BI::shared_memory_object probeShm(BI::open_only, segmentIdentity.c_str(), BI::read_only);
     }
-
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
+    catch (const BI::interprocess_exception &)
     {
       return PROCESS_FAIL;
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+
+    //Pools of topic go away with its segment, but blocks held in the global pool outlive it.
+    try
     {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
+      shmTopicSegment segment(identity);
+      if (segment.getPoolVec().empty())
+      {
+        auto globalPool_ptr = shmMsgPool::getGlobalPool();
+        auto ringBuffer_ptr = segment.getRingBuffer();
+        uint64_t startIndex;
+        shmIndexRingBuffer::ringBufferIndexBlockType block;
+        while (ringBuffer_ptr->getStartIndex(startIndex, block) == PROCESS_SUCCESS)
+        {
+          if (ringBuffer_ptr->moveStartIndex(startIndex, block) == PROCESS_SUCCESS)
+          {
+            globalPool_ptr->retireMsgShm(block.shmMsgIndex_);
+          }
+        }
+      }
     }
-    else
+    catch (const std::exception &e)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[calculateIndex(index)], sizeof(ringBufferIndexBlockType));
-      return PROCESS_SUCCESS;
+      LOG_WARN("messages of topic {} are left in the global pool: {}", identity, e.what());
     }
-    return PROCESS_FAIL;
+    return BI::shared_memory_object::remove(segmentIdentity.c_str()) ? PROCESS_SUCCESS : PROCESS_FAIL;
   }
 
-  bool shmIndexRingBuffer::watchStartBuffer(ringBufferIndexBlockType &indexBlock)
+  shmLatestTopic::shmLatestTopic(std::string_view identity, uint32_t capacity):
+    identity_(LATEST_PREFIX + std::string(identity))
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startIndexLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX || ringBuffer_raw_ptr_->startIndex_ == SHM_INVALID_INDEX)
+    using namespace BI;
+    //Segment is |head|channel|slot|value|.
+    auto channelOffset = alignCacheLine(sizeof(latestHeadType));
+    auto slotOffset = channelOffset + alignCacheLine(sizeof(shmChannel::IPC_t));
+    auto contentOffset = slotOffset + sizeof(latestSlotType);
+
+    bool isCreator = true;
+    try
     {
-      return PROCESS_FAIL;
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(create_only, identity_.c_str(), read_write);
+      segmentShm_ptr_->truncate(contentOffset + alignCacheLine(capacity));
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    catch (const interprocess_exception &e)
     {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
+      if (e.get_error_code() != already_exists_error)
+      {
+        throw;
+      }
+      isCreator = false;
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(open_only, identity_.c_str(), read_write);
+      waitSegmentCreator([this]() {
+        offset_t currentSize = 0;
+        return segmentShm_ptr_->get_size(currentSize) && currentSize > 0;
+      });
+    }
+    segmentShmRegion_ptr_ = std::make_shared<mapped_region>(*(segmentShm_ptr_.get()), read_write);
+    applyMemoryPolicy(segmentShmRegion_ptr_->get_address(), segmentShmRegion_ptr_->get_size());
+    auto segmentAddr = reinterpret_cast<char*>(segmentShmRegion_ptr_->get_address());
+    latestHead_raw_ptr_ = reinterpret_cast<latestHeadType*>(segmentAddr);
+    slot_raw_ptr_ = reinterpret_cast<latestSlotType*>(segmentAddr + slotOffset);
+    content_raw_ptr_ = segmentAddr + contentOffset;
+
+    if (isCreator)
+    {
+      latestHead_raw_ptr_->version_ = SHM_LATEST_SEGMENT_VERSION;
+      latestHead_raw_ptr_->capacity_ = capacity;
+      new(segmentAddr + channelOffset) shmChannel::IPC_t;
+      new(slot_raw_ptr_) latestSlotType{};
+      latestHead_raw_ptr_->segmentState_.store(SHM_SEGMENT_READY_FLAG, std::memory_order_release);
     }
     else
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      startIndex_shared_lock_ = std::move(startIndexLock);
-      return PROCESS_SUCCESS;
+      waitSegmentCreator([this]() {
+        return latestHead_raw_ptr_->segmentState_.load(std::memory_order_acquire) == SHM_SEGMENT_READY_FLAG;
+      });
+      if (latestHead_raw_ptr_->version_ != SHM_LATEST_SEGMENT_VERSION || \
+        contentOffset + latestHead_raw_ptr_->capacity_ > segmentShmRegion_ptr_->get_size())
+      {
+        throw std::runtime_error("dawn: shm latest value segment is mismatched");
+      }
+      if (latestHead_raw_ptr_->capacity_ != capacity)
+      {
+        LOG_WARN("latest value topic {} has capacity {}, {} is ignored", identity, latestHead_raw_ptr_->capacity_, capacity);
+      }
     }
-    return PROCESS_FAIL;
+    capacity_ = latestHead_raw_ptr_->capacity_;
+    channel_ptr_ = std::make_shared<shmChannel>(identity_, segmentShmRegion_ptr_, channelOffset);
   }
 
-  bool shmIndexRingBuffer::watchStartBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index)
+  bool shmLatestTopic::write(const void *write_data, const uint32_t data_len)
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startIndexLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX || ringBuffer_raw_ptr_->startIndex_ == SHM_INVALID_INDEX)
+    if (data_len > capacity_)
     {
+      LOG_ERROR("value of {} bytes exceeds capacity {} of {}", data_len, capacity_, identity_);
       return PROCESS_FAIL;
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    auto slot = slot_raw_ptr_;
+    uint64_t sequence;
+    if (lockSeqlock(slot->sequence_, slot->writerPid_, sequence, identity_) == PROCESS_FAIL)
     {
-      LOG_WARN("ring buffer is empty");
       return PROCESS_FAIL;
     }
-    else
+    std::memcpy(content_raw_ptr_, write_data, data_len);
+    slot->size_ = data_len;
+    slot->timeStamp_ = getTimestamp();
+    unlockSeqlock(slot->sequence_, slot->writerPid_, sequence);
+    channel_ptr_->notifyAll();
+    return PROCESS_SUCCESS;
+  }
+
+  uint64_t shmLatestTopic::copySlot(void *read_data, uint32_t &data_len, uint64_t lastSequence, uint64_t *timeStamp)
+  {
+    auto slot = slot_raw_ptr_;
+    for (uint32_t i = 0; i < SHM_SEQLOCK_RETRY_NUM; i++)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      index = ringBuffer_raw_ptr_->startIndex_;
-      startIndex_shared_lock_ = std::move(startIndexLock);
-      return PROCESS_SUCCESS;
+      auto sequence = slot->sequence_.load(std::memory_order_acquire);
+      if (sequence == lastSequence)
+      {
+        return 0;
+      }
+      if ((sequence & 1) != 0)
+      {
+        cpuRelax();
+        continue;
+      }
+      ///@note Size is clamped, a torn size from an overwriting writer must not overflow the buffer.
+      uint32_t size = std::min(slot->size_, capacity_);
+      uint64_t stamp = slot->timeStamp_;
+      std::memcpy(read_data, content_raw_ptr_, size);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->sequence_.load(std::memory_order_relaxed) == sequence)
+      {
+        data_len = size;
+        if (timeStamp != nullptr)
+        {
+          *timeStamp = stamp;
+        }
+        return sequence;
+      }
     }
-    return PROCESS_FAIL;
+    LOG_WARN("latest value of {} stays being written, its writer may be dead", identity_);
+    return 0;
   }
 
-  bool shmIndexRingBuffer::watchLatestBuffer(ringBufferIndexBlockType &indexBlock)
+  bool shmLatestTopic::read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type)
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       endLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
-    ///@note Lock start index prevent other process move start index overlap end index.
-    ///     It will cause ring buffer is empty, but still to read content.
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
+    auto readFunc = [this, read_data, &data_len]() {
+      auto lastSequence = lastSequence_.load(std::memory_order_relaxed);
+      auto sequence = copySlot(read_data, data_len, lastSequence, nullptr);
+      if (sequence == 0)
+      {
+        return false;
+      }
+      lastSequence_.store(sequence, std::memory_order_relaxed);
+      return true;
+    };
 
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
-    {
-      return PROCESS_FAIL;
-    }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
-    {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
-    }
-    else
+    switch (block_type)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[calculateLastIndex(ringBuffer_raw_ptr_->endIndex_)], sizeof(ringBufferIndexBlockType));
-      endIndex_shared_lock_ = std::move(endLock);
-      startIndex_shared_lock_ = std::move(startLock);
-      return PROCESS_SUCCESS;
+      case abstractTransport::BLOCKING_TYPE::NON_BLOCK:
+        return readFunc() ? PROCESS_SUCCESS : PROCESS_FAIL;
+
+      case abstractTransport::BLOCKING_TYPE::BUSY_POLL:
+        while (readFunc() == false)
+        {
+          cpuRelax();
+        }
+        return PROCESS_SUCCESS;
+
+      case abstractTransport::BLOCKING_TYPE::ADAPTIVE:
+      {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(SHM_SPIN_BUDGET_US);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+          if (readFunc())
+          {
+            return PROCESS_SUCCESS;
+          }
+          cpuRelax();
+        }
+        channel_ptr_->waitNotify(readFunc);
+        return PROCESS_SUCCESS;
+      }
+
+      default:
+        channel_ptr_->waitNotify(readFunc);
+        return PROCESS_SUCCESS;
     }
-    return PROCESS_FAIL;
   }
 
-  bool shmIndexRingBuffer::watchLatestBuffer(ringBufferIndexBlockType &indexBlock, uint32_t &index)
+  bool shmLatestTopic::readLatest(void *read_data, uint32_t &data_len, uint64_t *timeStamp)
+  {
+    //Sequence 0 means nothing is written, so it is never copied.
+    return copySlot(read_data, data_len, 0, timeStamp) != 0 ? PROCESS_SUCCESS : PROCESS_FAIL;
+  }
+
+  uint32_t shmLatestTopic::getCapacity() const
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       endLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
-    ///@note Lock start index prevent other process move start index overlap end index.
-    ///     It will cause ring buffer is empty, but still to read content.
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
+    return capacity_;
+  }
+
+  std::shared_ptr<shmChannel> shmLatestTopic::getChannel() const
+  {
+    return channel_ptr_;
+  }
 
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
+  bool shmLatestTopic::remove(std::string_view identity)
+  {
+    return BI::shared_memory_object::remove((LATEST_PREFIX + std::string(identity)).c_str()) ? PROCESS_SUCCESS : PROCESS_FAIL;
+  }
+
+  shmKeyedTopic::shmKeyedTopic(std::string_view identity, uint32_t maxKeyNum, uint32_t valueCapacity):
+    identity_(KEYED_PREFIX + std::string(identity))
+  {
+    using namespace BI;
+    if (maxKeyNum == 0 || maxKeyNum > (1U << 30))
     {
-      return PROCESS_FAIL;
+      throw std::runtime_error("dawn: keyed topic key number is invalid");
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    //Segment is |head|channel|slots|, slot is |slot head|value|.
+    auto channelOffset = alignCacheLine(sizeof(keyedHeadType));
+    auto slotsOffset = channelOffset + alignCacheLine(sizeof(shmChannel::IPC_t));
+    uint32_t slotNum = 1;
+    for (; slotNum < maxKeyNum * 2; slotNum <<= 1);
+    uint64_t slotSize = alignCacheLine(sizeof(keyedSlotType) + valueCapacity);
+
+    bool isCreator = true;
+    try
     {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(create_only, identity_.c_str(), read_write);
+      segmentShm_ptr_->truncate(slotsOffset + slotSize * slotNum);
+    }
+    catch (const interprocess_exception &e)
+    {
+      if (e.get_error_code() != already_exists_error)
+      {
+        throw;
+      }
+      isCreator = false;
+      segmentShm_ptr_ = std::make_shared<shared_memory_object>(open_only, identity_.c_str(), read_write);
+      waitSegmentCreator([this]() {
+        offset_t currentSize = 0;
+        return segmentShm_ptr_->get_size(currentSize) && currentSize > 0;
+      });
+    }
+    segmentShmRegion_ptr_ = std::make_shared<mapped_region>(*(segmentShm_ptr_.get()), read_write);
+    applyMemoryPolicy(segmentShmRegion_ptr_->get_address(), segmentShmRegion_ptr_->get_size());
+    auto segmentAddr = reinterpret_cast<char*>(segmentShmRegion_ptr_->get_address());
+    keyedHead_raw_ptr_ = reinterpret_cast<keyedHeadType*>(segmentAddr);
+    slots_raw_ptr_ = segmentAddr + slotsOffset;
+
+    ///@note Truncated segment is zero filled, so every slot starts as SLOT_EMPTY without a pass over the table.
+    if (isCreator)
+    {
+      keyedHead_raw_ptr_->version_ = SHM_KEYED_SEGMENT_VERSION;
+      keyedHead_raw_ptr_->slotNum_ = slotNum;
+      keyedHead_raw_ptr_->valueCapacity_ = valueCapacity;
+      keyedHead_raw_ptr_->slotSize_ = slotSize;
+      new(segmentAddr + channelOffset) shmChannel::IPC_t;
+      keyedHead_raw_ptr_->segmentState_.store(SHM_SEGMENT_READY_FLAG, std::memory_order_release);
     }
     else
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[calculateLastIndex(ringBuffer_raw_ptr_->endIndex_)], sizeof(ringBufferIndexBlockType));
-      index = calculateLastIndex(ringBuffer_raw_ptr_->endIndex_);
-      endIndex_shared_lock_ = std::move(endLock);
-      startIndex_shared_lock_ = std::move(startLock);
-      return PROCESS_SUCCESS;
+      waitSegmentCreator([this]() {
+        return keyedHead_raw_ptr_->segmentState_.load(std::memory_order_acquire) == SHM_SEGMENT_READY_FLAG;
+      });
+      auto head = keyedHead_raw_ptr_;
+      if (head->version_ != SHM_KEYED_SEGMENT_VERSION || head->slotSize_ < sizeof(keyedSlotType) + head->valueCapacity_ || \
+        slotsOffset + head->slotSize_ * head->slotNum_ > segmentShmRegion_ptr_->get_size())
+      {
+        throw std::runtime_error("dawn: shm keyed topic segment is mismatched");
+      }
+      if (head->slotNum_ != slotNum || head->valueCapacity_ != valueCapacity)
+      {
+        LOG_WARN("keyed topic {} has {} slots of {} bytes, requested geometry is ignored", identity, head->slotNum_, head->valueCapacity_);
+      }
     }
-    return PROCESS_FAIL;
-  }
-
-  bool shmIndexRingBuffer::stopWatchSpecificIndexBuffer()
-  {
-    startIndex_shared_lock_.unlock();
-    endIndex_shared_lock_.unlock();
-    return PROCESS_SUCCESS;
+    slotNum_ = keyedHead_raw_ptr_->slotNum_;
+    valueCapacity_ = keyedHead_raw_ptr_->valueCapacity_;
+    slotSize_ = keyedHead_raw_ptr_->slotSize_;
+    channel_ptr_ = std::make_shared<shmChannel>(identity_, segmentShmRegion_ptr_, channelOffset);
   }
 
-  bool shmIndexRingBuffer::stopWatchStartIndex()
+  shmKeyedTopic::keyedSlotType* shmKeyedTopic::getSlot(uint32_t index) const
   {
-    startIndex_shared_lock_.unlock();
-    return PROCESS_SUCCESS;
+    return reinterpret_cast<keyedSlotType*>(FIND_SHARE_MEM_BLOCK_ADDR(slots_raw_ptr_, index, slotSize_));
   }
 
-  bool shmIndexRingBuffer::stopWatchLatestBuffer()
+  shmKeyedTopic::keyedSlotType* shmKeyedTopic::findSlot(uint64_t key, bool claim)
   {
-    startIndex_shared_lock_.unlock();
-    endIndex_shared_lock_.unlock();
-    return PROCESS_SUCCESS;
+    //Fibonacci hashing spreads sequential keys like entity ids over the table.
+    uint32_t index = static_cast<uint32_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) & (slotNum_ - 1);
+    for (uint32_t probe = 0; probe < slotNum_; probe++, index = (index + 1) & (slotNum_ - 1))
+    {
+      auto slot = getSlot(index);
+      auto state = slot->state_.load(std::memory_order_acquire);
+      if (state == SLOT_EMPTY)
+      {
+        if (!claim)
+        {
+          return nullptr;
+        }
+        if (slot->state_.compare_exchange_strong(state, SLOT_CLAIMING, std::memory_order_acq_rel))
+        {
+          slot->key_ = key;
+          slot->state_.store(SLOT_USED, std::memory_order_release);
+          return slot;
+        }
+      }
+      //Key of a slot being claimed is stored in a moment. A claimer which died before storing it leaves the slot
+      //claiming forever, so it is skipped as a slot of another key.
+      for (uint32_t i = 0; state == SLOT_CLAIMING && i < SHM_SEQLOCK_RETRY_NUM; i++)
+      {
+        cpuRelax();
+        state = slot->state_.load(std::memory_order_acquire);
+      }
+      if (state == SLOT_USED && slot->key_ == key)
+      {
+        return slot;
+      }
+    }
+    return nullptr;
   }
 
-  bool  shmIndexRingBuffer::getStartIndex(uint32_t &storeIndex, ringBufferIndexBlockType &indexBlock)
+  bool shmKeyedTopic::write(uint64_t key, const void *write_data, const uint32_t data_len)
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startIndexLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX || ringBuffer_raw_ptr_->startIndex_ == SHM_INVALID_INDEX)
+    if (data_len > valueCapacity_)
     {
+      LOG_ERROR("value of {} bytes exceeds capacity {} of {}", data_len, valueCapacity_, identity_);
       return PROCESS_FAIL;
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    auto slot = findSlot(key, true);
+    if (slot == nullptr)
     {
-      LOG_WARN("ring buffer is empty");
+      LOG_ERROR("keyed topic {} is full, key {} is dropped", identity_, key);
       return PROCESS_FAIL;
     }
-    else
+
+    uint64_t sequence;
+    if (lockSeqlock(slot->sequence_, slot->writerPid_, sequence, identity_) == PROCESS_FAIL)
     {
-      storeIndex = ringBuffer_raw_ptr_->startIndex_;
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[ringBuffer_raw_ptr_->startIndex_], sizeof(ringBufferIndexBlockType));
-      return PROCESS_SUCCESS;
+      return PROCESS_FAIL;
     }
-    return PROCESS_FAIL;
+    std::memcpy(reinterpret_cast<char*>(slot) + sizeof(keyedSlotType), write_data, data_len);
+    slot->size_ = data_len;
+    slot->timeStamp_ = getTimestamp();
+    ///@note Update number is taken while slot is odd, so a scan which sees the number later also sees the value.
+    slot->updateSequence_ = keyedHead_raw_ptr_->updateSequence_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    unlockSeqlock(slot->sequence_, slot->writerPid_, sequence);
+    channel_ptr_->notifyAll();
+    return PROCESS_SUCCESS;
   }
 
-  bool shmIndexRingBuffer::watchSpecificIndexBuffer(uint32_t index, ringBufferIndexBlockType &indexBlock)
+  uint64_t shmKeyedTopic::copySlot(keyedSlotType *slot, void *read_data, uint32_t &data_len, uint64_t *timeStamp)
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       endLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
-    ///@note Lock start index prevent other process move start index overlap end index.
-    ///     It will cause ring buffer is empty, but still to read content.
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-
-    if (checkIndexValid(index) == PROCESS_FAIL)
+    for (uint32_t i = 0; i < SHM_SEQLOCK_RETRY_NUM; i++)
     {
-      return PROCESS_FAIL;
+      auto sequence = slot->sequence_.load(std::memory_order_acquire);
+      if ((sequence & 1) != 0)
+      {
+        cpuRelax();
+        continue;
+      }
+      uint32_t size = std::min(slot->size_, valueCapacity_);
+      uint64_t stamp = slot->timeStamp_;
+      uint64_t updateSequence = slot->updateSequence_;
+      std::memcpy(read_data, reinterpret_cast<char*>(slot) + sizeof(keyedSlotType), size);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->sequence_.load(std::memory_order_relaxed) == sequence)
+      {
+        data_len = size;
+        if (timeStamp != nullptr)
+        {
+          *timeStamp = stamp;
+        }
+        return updateSequence;
+      }
     }
+    LOG_WARN("key {} of {} stays being written, its writer may be dead", slot->key_, identity_);
+    return 0;
+  }
 
-    if (ringBuffer_raw_ptr_->endIndex_ == SHM_INVALID_INDEX)
+  bool shmKeyedTopic::read(uint64_t key, void *read_data, uint32_t &data_len, uint64_t *timeStamp)
+  {
+    auto slot = findSlot(key, false);
+    if (slot == nullptr || copySlot(slot, read_data, data_len, timeStamp) == 0)
     {
       return PROCESS_FAIL;
     }
-    else if (ringBuffer_raw_ptr_->endIndex_ == ringBuffer_raw_ptr_->startIndex_)
+    return PROCESS_SUCCESS;
+  }
+
+  uint32_t shmKeyedTopic::scanDirty(const keyedReadFunc &callback, uint64_t &cursor, std::vector<char> &buffer)
+  {
+    ///@note Keys updated after the snapshot are left to the next scan, so cursor can jump to the snapshot
+    ///      without skipping a key whose write is still in flight.
+    auto snapshot = keyedHead_raw_ptr_->updateSequence_.load(std::memory_order_acquire);
+    if (snapshot == cursor)
     {
-      LOG_WARN("ring buffer is empty");
-      return PROCESS_FAIL;
+      return 0;
     }
-    else
+    uint32_t readCount = 0;
+    for (uint32_t index = 0; index < slotNum_; index++)
     {
-      std::memcpy(&indexBlock, &ringBuffer_raw_ptr_->ringBufferBlock_[calculateIndex(index)], sizeof(ringBufferIndexBlockType));
-      endIndex_shared_lock_ = std::move(endLock);
-      startIndex_shared_lock_ = std::move(startLock);
+      auto slot = getSlot(index);
+      if (slot->state_.load(std::memory_order_acquire) != SLOT_USED)
+      {
+        continue;
+      }
+      uint32_t len = 0;
+      auto updateSequence = copySlot(slot, buffer.data(), len, nullptr);
+      if (updateSequence > cursor && updateSequence <= snapshot)
+      {
+        callback(slot->key_, buffer.data(), len);
+        readCount++;
+      }
+    }
+    cursor = snapshot;
+    return readCount;
+  }
 
-      return PROCESS_SUCCESS;
+  uint32_t shmKeyedTopic::readDirty(const keyedReadFunc &callback, uint64_t &cursor, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    std::vector<char> buffer(valueCapacity_);
+    if (block_type == abstractTransport::BLOCKING_TYPE::NON_BLOCK)
+    {
+      return scanDirty(callback, cursor, buffer);
     }
-    return PROCESS_FAIL;
+    uint32_t readCount = 0;
+    channel_ptr_->waitNotify([this, &callback, &cursor, &buffer, &readCount]() {
+      readCount = scanDirty(callback, cursor, buffer);
+      return readCount != 0;
+    });
+    return readCount;
   }
 
-  bool shmIndexRingBuffer::exclusiveLockBuffer()
+  uint32_t shmKeyedTopic::getValueCapacity() const
   {
-    BI::scoped_lock<BI::interprocess_sharable_mutex>       endLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
-    BI::scoped_lock<BI::interprocess_sharable_mutex>       startLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-    endIndex_exclusive_lock_ = std::move(endLock);
-    startIndex_exclusive_lock_ = std::move(startLock);
-    return PROCESS_SUCCESS;
+    return valueCapacity_;
   }
 
-  bool shmIndexRingBuffer::exclusiveUnlockBuffer()
+  uint32_t shmKeyedTopic::getSlotNum() const
   {
-    endIndex_exclusive_lock_.unlock();
-    startIndex_exclusive_lock_.unlock();
-    return PROCESS_SUCCESS;
+    return slotNum_;
   }
 
-  bool shmIndexRingBuffer::sharedLockBuffer()
+  std::shared_ptr<shmChannel> shmKeyedTopic::getChannel() const
   {
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       endLock(ipc_ptr_->mechanism_raw_ptr_->endIndex_mutex_);
-    BI::sharable_lock<BI::interprocess_sharable_mutex>       startLock(ipc_ptr_->mechanism_raw_ptr_->startIndex_mutex_);
-    endIndex_shared_lock_ = std::move(endLock);
-    startIndex_shared_lock_ = std::move(startLock);
-    return PROCESS_SUCCESS;
+    return channel_ptr_;
   }
 
-  bool shmIndexRingBuffer::sharedUnlockBuffer()
+  bool shmKeyedTopic::remove(std::string_view identity)
   {
-    endIndex_shared_lock_.unlock();
-    startIndex_shared_lock_.unlock();
-    return PROCESS_SUCCESS;
+    return BI::shared_memory_object::remove((KEYED_PREFIX + std::string(identity)).c_str()) ? PROCESS_SUCCESS : PROCESS_FAIL;
   }
 
-  bool shmIndexRingBuffer::compareAndMoveStartIndex(ringBufferIndexBlockType &indexBlock)
+  shmLoanedMsg::~shmLoanedMsg()
   {
-    ///@todo Compare index block content and decide to whether move start index.
-    return PROCESS_SUCCESS;
+    release();
+  }
+
+  shmLoanedMsg::shmLoanedMsg(shmLoanedMsg &&loanedMsg) :
+    size_(loanedMsg.size_),
+    msgIndexVec_(std::move(loanedMsg.msgIndexVec_)),
+    fragments_(std::move(loanedMsg.fragments_)),
+    shmPool_ptr_(std::move(loanedMsg.shmPool_ptr_))
+  {
+    loanedMsg.size_ = 0;
+    loanedMsg.msgIndexVec_.clear();
+    loanedMsg.fragments_.clear();
   }
 
-  bool shmIndexRingBuffer::checkIndexValid(uint32_t index)
+  shmLoanedMsg& shmLoanedMsg::operator=(shmLoanedMsg &&loanedMsg)
   {
-    auto correctedIndex = calculateIndex(index);
-    if (ringBuffer_raw_ptr_->startIndex_ != SHM_INVALID_INDEX && ringBuffer_raw_ptr_->endIndex_ != SHM_INVALID_INDEX)
+    if (this != &loanedMsg)
     {
-      if (ringBuffer_raw_ptr_->startIndex_ < ringBuffer_raw_ptr_->endIndex_ && ringBuffer_raw_ptr_->startIndex_ <= correctedIndex && correctedIndex < ringBuffer_raw_ptr_->endIndex_)
-      {
-        return true;
-      }
-      else if (ringBuffer_raw_ptr_->startIndex_ > ringBuffer_raw_ptr_->endIndex_ && (ringBuffer_raw_ptr_->startIndex_ <= correctedIndex || correctedIndex < ringBuffer_raw_ptr_->endIndex_))
-      {
-        return true;
-      }
-      else
-      {
-        return false;
-      }
+      release();
+      size_ = loanedMsg.size_;
+      msgIndexVec_ = std::move(loanedMsg.msgIndexVec_);
+      fragments_ = std::move(loanedMsg.fragments_);
+      shmPool_ptr_ = std::move(loanedMsg.shmPool_ptr_);
+      loanedMsg.size_ = 0;
+      loanedMsg.msgIndexVec_.clear();
+      loanedMsg.fragments_.clear();
     }
-    return false;
+    return *this;
   }
 
-  uint32_t shmIndexRingBuffer::calculateIndex(uint32_t ringBufferIndex)
+  bool shmLoanedMsg::valid() const
   {
-    return ringBufferIndex % (ringBuffer_raw_ptr_->totalIndex_);
+    return msgIndexVec_.empty() == false;
   }
 
-  uint32_t shmIndexRingBuffer::calculateLastIndex(uint32_t ringBufferIndex)
+  uint32_t shmLoanedMsg::size() const
   {
-    return ringBufferIndex == 0 ? (ringBuffer_raw_ptr_->totalIndex_ - 1) : (ringBufferIndex - 1);
+    return size_;
   }
 
-  shmMsgPool::shmMsgPool(std::string_view identity):
-    defaultPriority_(0),
-    identity_(identity),
-    mechanismIdentity_(MECHANISM_PREFIX + identity_),
-    mqIdentity_(MESSAGE_QUEUE_PREFIX + identity_)
+  void* shmLoanedMsg::data()
   {
-    using namespace BI;
-    ipc_ptr_ = std::make_shared<interprocessMechanism<IPC_t>>(mechanismIdentity_);
-    availMsg_mq_ptr_ = std::make_shared<message_queue>(open_or_create, mqIdentity_.c_str(), SHM_BLOCK_NUM, sizeof(uint32_t));
-    msgBufferShm_ptr_ = std::make_shared<shared_memory_object>(open_or_create, identity_.c_str(), read_write);
-    msgBufferShm_ptr_->truncate(SHM_TOTAL_SIZE);
-    msgBufferShmRegion_ptr_ = std::make_shared<mapped_region>(*(msgBufferShm_ptr_.get()), read_write);
-    msgBuffer_raw_ptr_ = reinterpret_cast<void*>(msgBufferShmRegion_ptr_->get_address());
-
-    if (ipc_ptr_->mechanism_raw_ptr_->msgPoolInitialFlag_.try_wait())
+    if (fragments_.size() != 1)
     {
-      for (uint32_t i = 0; i < SHM_BLOCK_NUM; i++)
-      {
-        availMsg_mq_ptr_->send(&i, sizeof(i), defaultPriority_);
-      }
+      return nullptr;
     }
+    return fragments_[0].iov_base;
   }
 
-  std::vector<uint32_t> shmMsgPool::requireMsgShm(uint32_t data_size)
+  const std::vector<iovec>& shmLoanedMsg::fragments() const
   {
-    assert(data_size != 0 && " require zero shm size");
-    uint32_t needBlockNum = (data_size + SHM_BLOCK_CONTENT_SIZE) / SHM_BLOCK_CONTENT_SIZE;
-    if (needBlockNum > SHM_BLOCK_NUM)
-    {
-      throw std::runtime_error("dawn: allocate too big share memory block");
-    }
-    std::vector<uint32_t>   indexVec;
-    indexVec.reserve(needBlockNum);
+    return fragments_;
+  }
 
-    for (uint32_t i = 0; i < needBlockNum; i++)
+  void shmLoanedMsg::release()
+  {
+    if (shmPool_ptr_ != nullptr && msgIndexVec_.empty() == false)
     {
-      auto index = requireOneBlock();
-      if (index == SHM_INVALID_INDEX)
-      {
-        for (auto it : indexVec)
-        {
-          recycleMsgShm(it);
-        }
-        //@todo add dawn exception
-        throw std::runtime_error("dawn: too low shm resource");
-      }
-      indexVec.emplace_back(index);
+      shmPool_ptr_->recycleMsgChain(msgIndexVec_.front());
     }
-
-    return indexVec;
+    msgIndexVec_.clear();
+    fragments_.clear();
+    size_ = 0;
   }
 
-  uint32_t shmMsgPool::requireOneBlock()
+  shmBorrowedMsg::~shmBorrowedMsg()
   {
-    using namespace BI;
-    uint32_t index = 0;
-    message_queue::size_type recvd_size;
-    if (availMsg_mq_ptr_->try_receive(&index, sizeof(index), recvd_size, defaultPriority_) == false)
-    {
-      return SHM_INVALID_INDEX;
-    }
-    auto mem = FIND_SHARE_MEM_BLOCK_ADDR(msgBuffer_raw_ptr_, index);
+    release();
+  }
 
-    //initialize share memory block
-    new(mem) msgType;
+  shmBorrowedMsg::shmBorrowedMsg(shmBorrowedMsg &&borrowedMsg) :
+    size_(borrowedMsg.size_),
+    headIndex_(borrowedMsg.headIndex_),
+    fragments_(std::move(borrowedMsg.fragments_)),
+    shmPool_ptr_(std::move(borrowedMsg.shmPool_ptr_))
+  {
+    borrowedMsg.size_ = 0;
+    borrowedMsg.headIndex_ = SHM_INVALID_INDEX;
+    borrowedMsg.fragments_.clear();
+  }
 
-    if (recvd_size != sizeof(index))
+  shmBorrowedMsg& shmBorrowedMsg::operator=(shmBorrowedMsg &&borrowedMsg)
+  {
+    if (this != &borrowedMsg)
     {
-      return SHM_INVALID_INDEX;
+      release();
+      size_ = borrowedMsg.size_;
+      headIndex_ = borrowedMsg.headIndex_;
+      fragments_ = std::move(borrowedMsg.fragments_);
+      shmPool_ptr_ = std::move(borrowedMsg.shmPool_ptr_);
+      borrowedMsg.size_ = 0;
+      borrowedMsg.headIndex_ = SHM_INVALID_INDEX;
+      borrowedMsg.fragments_.clear();
     }
-    return index;
+    return *this;
   }
 
-  void* shmMsgPool::getMsgRawBuffer()
+  bool shmBorrowedMsg::valid() const
   {
-    return msgBuffer_raw_ptr_;
+    return headIndex_ != SHM_INVALID_INDEX;
   }
 
-  bool shmMsgPool::recycleMsgShm(uint32_t index)
+  uint32_t shmBorrowedMsg::size() const
   {
-    assert(index < (SHM_BLOCK_NUM) && "msg shm index is out of range");
+    return size_;
+  }
 
-    auto mem = FIND_SHARE_MEM_BLOCK_ADDR(msgBuffer_raw_ptr_, index);
+  const void* shmBorrowedMsg::data() const
+  {
+    if (fragments_.size() != 1)
+    {
+      return nullptr;
+    }
+    return fragments_[0].iov_base;
+  }
 
-    //Initialize share memory block and clear shm block's content
-    auto msgIns = (new(mem) msgType);
-    std::memset(&msgIns->content_, 0x0, SHM_BLOCK_CONTENT_SIZE);
+  const std::vector<iovec>& shmBorrowedMsg::fragments() const
+  {
+    return fragments_;
+  }
 
-    availMsg_mq_ptr_->send(&index, sizeof(index), defaultPriority_);
-    return true;
+  void shmBorrowedMsg::release()
+  {
+    if (headIndex_ != SHM_INVALID_INDEX && shmPool_ptr_ != nullptr)
+    {
+      shmPool_ptr_->unpinMsgShm(headIndex_);
+    }
+    headIndex_ = SHM_INVALID_INDEX;
+    fragments_.clear();
+    size_ = 0;
   }
 
   shmTransport::shmTransport()
@@ -574,11 +2020,13 @@ namespace  dawn
 
   shmTransport::~shmTransport()
   {
+    closeEventFd();
   }
 
-  shmTransport::shmTransport(std::string_view identity, std::shared_ptr<qosCfg> qosCfg_ptr)
+  shmTransport::shmTransport(std::string_view identity, std::shared_ptr<qosCfg> qosCfg_ptr):
+    blockType_(qosCfg_ptr->blockType_)
   {
-    auto impl = std::make_unique<shmTransportImpl>(identity);
+    auto impl = std::make_unique<shmTransportImpl>(identity, *qosCfg_ptr);
     if (qosCfg_ptr->qosType_ == qosCfg::QOS_TYPE::EFFICIENT)
     {
       tpController_ptr_ = std::make_unique<efficientTpController_shm>(std::move(impl), *qosCfg_ptr);
@@ -591,7 +2039,9 @@ namespace  dawn
 
   void shmTransport::initialize(std::string_view identity, std::shared_ptr<qosCfg> qosCfg_ptr)
   {
-    auto impl = std::make_unique<shmTransportImpl>(identity);
+    closeEventFd();
+    blockType_ = qosCfg_ptr->blockType_;
+    auto impl = std::make_unique<shmTransportImpl>(identity, *qosCfg_ptr);
     if (qosCfg_ptr->qosType_ == qosCfg::QOS_TYPE::EFFICIENT)
     {
       tpController_ptr_ = std::make_unique<efficientTpController_shm>(std::move(impl), *qosCfg_ptr);
@@ -607,6 +2057,26 @@ namespace  dawn
     return tpController_ptr_->write(write_data, data_len);
   }
 
+  bool shmTransport::write(const iovec *iov, int iovcnt)
+  {
+    return tpController_ptr_->write(iov, iovcnt);
+  }
+
+  bool shmTransport::writeBatch(const iovec *msgs, uint32_t msgNum)
+  {
+    return tpController_ptr_->writeBatch(msgs, msgNum);
+  }
+
+  bool shmTransport::loan(const uint32_t data_len, shmLoanedMsg &loanedMsg)
+  {
+    return tpController_ptr_->loan(data_len, loanedMsg);
+  }
+
+  bool shmTransport::publish(shmLoanedMsg &loanedMsg)
+  {
+    return tpController_ptr_->publish(loanedMsg);
+  }
+
   bool shmTransport::read(void *read_data, uint32_t &data_len, BLOCKING_TYPE block_type)
   {
     return tpController_ptr_->read(read_data, data_len, block_type);
@@ -614,7 +2084,22 @@ namespace  dawn
 
   bool shmTransport::read(void *read_data, uint32_t &data_len)
   {
-    return tpController_ptr_->read(read_data, data_len, BLOCKING_TYPE::BLOCK);
+    return tpController_ptr_->read(read_data, data_len, blockType_);
+  }
+
+  bool shmTransport::borrow(shmBorrowedMsg &borrowedMsg, BLOCKING_TYPE block_type)
+  {
+    return tpController_ptr_->borrow(borrowedMsg, block_type);
+  }
+
+  bool shmTransport::borrow(shmBorrowedMsg &borrowedMsg)
+  {
+    return tpController_ptr_->borrow(borrowedMsg, blockType_);
+  }
+
+  bool shmTransport::readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, BLOCKING_TYPE block_type)
+  {
+    return tpController_ptr_->readBatch(callback, maxCount, readCount, block_type);
   }
 
   bool shmTransport::wait()
@@ -622,9 +2107,58 @@ namespace  dawn
     return PROCESS_SUCCESS;
   }
 
-  uint32_t  getTimestamp()
+  std::shared_ptr<shmChannel> shmTransport::getChannel()
+  {
+    return tpController_ptr_->getChannel();
+  }
+
+  int shmTransport::getEventFd()
+  {
+    if (eventFd_ != INVALID_VALUE)
+    {
+      return eventFd_;
+    }
+    auto eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd == INVALID_VALUE)
+    {
+      LOG_ERROR("can not create eventfd: {}", strerror(errno));
+      return INVALID_VALUE;
+    }
+    auto bridge_ptr = shmEventBridge::getEventBridge();
+    if (bridge_ptr->registerEventFd(eventFd, getChannel()) == PROCESS_FAIL)
+    {
+      close(eventFd);
+      return INVALID_VALUE;
+    }
+    eventFd_ = eventFd;
+    eventBridge_ptr_ = std::move(bridge_ptr);
+    return eventFd_;
+  }
+
+  void shmTransport::clearEvent()
+  {
+    uint64_t count = 0;
+    if (eventFd_ != INVALID_VALUE)
+    {
+      (void)::read(eventFd_, &count, sizeof(count));
+    }
+  }
+
+  void shmTransport::closeEventFd()
+  {
+    if (eventFd_ == INVALID_VALUE)
+    {
+      return;
+    }
+    eventBridge_ptr_->unregisterEventFd(eventFd_);
+    close(eventFd_);
+    eventFd_ = INVALID_VALUE;
+    eventBridge_ptr_.reset();
+  }
+
+  uint64_t  getTimestamp()
   {
     using namespace std::chrono;
-    return duration_cast<microseconds>(high_resolution_clock::now().time_since_epoch()).count();
+    return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
   }
 }
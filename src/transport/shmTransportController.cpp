@@ -26,23 +26,75 @@ namespace dawn
     return shmImpl_->baseWrite(write_data, data_len);
   }
 
+  bool efficientTpController_shm::write(const iovec *iov, int iovcnt)
+  {
+    return shmImpl_->baseWrite(iov, iovcnt);
+  }
+
+  bool efficientTpController_shm::writeBatch(const iovec *msgs, uint32_t msgNum)
+  {
+    return shmImpl_->baseWriteBatch(msgs, msgNum);
+  }
+
+  bool efficientTpController_shm::loan(const uint32_t data_len, shmLoanedMsg &loanedMsg)
+  {
+    return shmImpl_->loanMsg(data_len, loanedMsg);
+  }
+
+  bool efficientTpController_shm::publish(shmLoanedMsg &loanedMsg)
+  {
+    return shmImpl_->publishLoanedMsg(loanedMsg);
+  }
+
   bool efficientTpController_shm::read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type)
   {
-    auto  subscribeLatestMsg_func = [this, &read_data, &data_len]() {
+    return consumeMsg([this, &read_data, &data_len](uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block) {
+      return shmImpl_->readMsg(read_data, data_len, ringBufferIndex, block);
+    }, block_type);
+  }
+
+  bool efficientTpController_shm::borrow(shmBorrowedMsg &borrowedMsg, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    return consumeMsg([this, &borrowedMsg](uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block) {
+      return shmImpl_->borrowMsg(ringBufferIndex, block, borrowedMsg);
+    }, block_type);
+  }
+
+  bool efficientTpController_shm::readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    readCount = 0;
+    std::vector<char> buffer;
+    uint32_t data_len = 0;
+    if (maxCount == 0 || consumeMsg([this, &buffer, &data_len](uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block) {
+      buffer.resize(block.msgSize_);
+      return shmImpl_->readMsg(buffer.data(), data_len, ringBufferIndex, block);
+    }, block_type) == PROCESS_FAIL)
+    {
+      return PROCESS_FAIL;
+    }
+    callback(buffer.data(), data_len);
+    readCount = 1;
+    return PROCESS_SUCCESS;
+  }
+
+  template<typename FUNC_T>
+  bool efficientTpController_shm::consumeMsg(FUNC_T &&consumeFunc, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    auto  subscribeLatestMsg_func = [this, &consumeFunc]() {
       shmIndexRingBuffer::ringBufferIndexBlockType block;
+      uint64_t    ringBufferIndex;
       bool result = false;
       std::unique_lock<std::shared_mutex> lock(mutex_);
-      if (shmImpl_->subscribeLatestMsgAndSharableLock(block) == PROCESS_SUCCESS)
+      if (shmImpl_->subscribeLatestMsg(block, ringBufferIndex) == PROCESS_SUCCESS)
       {
-        if (tasteMsgType(block) == tpController::MSG_FRESHNESS::FRESH)
+        if (tasteMsgType(ringBufferIndex) == tpController::MSG_FRESHNESS::FRESH)
         {
-          updateLatestMsg(block);
-          if (shmImpl_->readBuffer(read_data, data_len, block.shmMsgIndex_, block.msgSize_) == PROCESS_SUCCESS)
+          if (consumeFunc(ringBufferIndex, block) == PROCESS_SUCCESS)
           {
+            updateLatestMsg(block, ringBufferIndex);
             result = true;
           }
         }
-        shmImpl_->stopWatchRingBuffer();
       }
       return result;
     };
@@ -53,21 +105,8 @@ namespace dawn
       return PROCESS_SUCCESS;
     }
 
-    //Block until message arrival
-    if (block_type == abstractTransport::BLOCKING_TYPE::BLOCK)
-    {
-      shmImpl_->channel_ptr_->waitNotify(subscribeLatestMsg_func);
-      return PROCESS_SUCCESS;
-    }
-    else
-    {
-      auto result = shmImpl_->channel_ptr_->tryWaitNotify(subscribeLatestMsg_func);
-      if (result == false)
-      {
-        return PROCESS_FAIL;
-      }
-    }
-    return PROCESS_FAIL;
+    //Wait until message arrival
+    return shmImpl_->waitMsg(subscribeLatestMsg_func, block_type, qosCfg_.spinBudgetUs_);
   }
 
   qosCfg::QOS_TYPE efficientTpController_shm::getQosType()
@@ -75,10 +114,14 @@ namespace dawn
     return qosCfg_.qosType_;
   }
 
-  tpController::MSG_FRESHNESS efficientTpController_shm::tasteMsgType(shmIndexRingBuffer::ringBufferIndexBlockType &msg)
+  std::shared_ptr<shmChannel> efficientTpController_shm::getChannel()
   {
+    return shmImpl_->channel_ptr_;
+  }
 
-    if (latestMsg_.timeStamp_ < msg.timeStamp_)
+  tpController::MSG_FRESHNESS efficientTpController_shm::tasteMsgType(uint64_t ringBufferIndex)
+  {
+    if (latestIndex_ == SHM_INVALID_SEQUENCE || latestIndex_ < ringBufferIndex)
     {
       return tpController::MSG_FRESHNESS::FRESH;
     }
@@ -88,19 +131,20 @@ namespace dawn
     }
   }
 
-  bool efficientTpController_shm::updateLatestMsg(shmIndexRingBuffer::ringBufferIndexBlockType  &msg)
+  bool efficientTpController_shm::updateLatestMsg(shmIndexRingBuffer::ringBufferIndexBlockType  &msg, uint64_t ringBufferIndex)
   {
-    if (std::memcmp(&latestMsg_, &msg, sizeof(shmIndexRingBuffer::ringBufferIndexBlockType)) == 0)
+    if (latestIndex_ == ringBufferIndex)
     {
       return PROCESS_SUCCESS;
     }
-    else if (latestMsg_.timeStamp_ > msg.timeStamp_)
+    else if (latestIndex_ != SHM_INVALID_SEQUENCE && latestIndex_ > ringBufferIndex)
     {
       return PROCESS_FAIL;
     }
     else
     {
       std::memcpy(&latestMsg_, &msg, sizeof(shmIndexRingBuffer::ringBufferIndexBlockType));
+      latestIndex_ = ringBufferIndex;
       return PROCESS_SUCCESS;
     }
   }
@@ -116,6 +160,11 @@ namespace dawn
   {
   }
 
+  reliableTpController_shm::~reliableTpController_shm()
+  {
+    shmImpl_->ringBuffer_ptr_->unregisterReader(readerId_);
+  }
+
   bool reliableTpController_shm::initialize(std::any config)
   {
     qosCfg_ = std::any_cast<qosCfg>(config);
@@ -127,11 +176,140 @@ namespace dawn
     return shmImpl_->baseWrite(write_data, data_len);
   }
 
+  bool reliableTpController_shm::write(const iovec *iov, int iovcnt)
+  {
+    return shmImpl_->baseWrite(iov, iovcnt);
+  }
+
+  bool reliableTpController_shm::writeBatch(const iovec *msgs, uint32_t msgNum)
+  {
+    return shmImpl_->baseWriteBatch(msgs, msgNum);
+  }
+
+  bool reliableTpController_shm::loan(const uint32_t data_len, shmLoanedMsg &loanedMsg)
+  {
+    return shmImpl_->loanMsg(data_len, loanedMsg);
+  }
+
+  bool reliableTpController_shm::publish(shmLoanedMsg &loanedMsg)
+  {
+    return shmImpl_->publishLoanedMsg(loanedMsg);
+  }
+
   bool reliableTpController_shm::read(void *read_data, uint32_t &data_len, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    return consumeMsg([this, &read_data, &data_len](uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block) {
+      return shmImpl_->readMsg(read_data, data_len, ringBufferIndex, block);
+    }, block_type);
+  }
+
+  bool reliableTpController_shm::borrow(shmBorrowedMsg &borrowedMsg, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    return consumeMsg([this, &borrowedMsg](uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block) {
+      return shmImpl_->borrowMsg(ringBufferIndex, block, borrowedMsg);
+    }, block_type);
+  }
+
+  bool reliableTpController_shm::readBatch(const batchReadFunc &callback, uint32_t maxCount, uint32_t &readCount, abstractTransport::BLOCKING_TYPE block_type)
+  {
+    readCount = 0;
+    if (maxCount == 0)
+    {
+      return PROCESS_FAIL;
+    }
+    attachReaderCursor();
+    std::vector<char> buffer;
+    auto drainMsg_func = [this, &callback, maxCount, &readCount, &buffer]() {
+      readCount = drainMsg(callback, maxCount, buffer);
+      return readCount != 0;
+    };
+
+    if (drainMsg_func() == true)
+    {
+      return PROCESS_SUCCESS;
+    }
+    return shmImpl_->waitMsg(drainMsg_func, block_type, qosCfg_.spinBudgetUs_);
+  }
+
+  uint32_t reliableTpController_shm::drainMsg(const batchReadFunc &callback, uint32_t maxCount, std::vector<char> &buffer)
+  {
+    //Take one snapshot of ring buffer.
+    shmIndexRingBuffer::ringBufferIndexBlockType block;
+    uint64_t startIndex;
+    if (shmImpl_->requireStartMsg(startIndex, block) == PROCESS_FAIL)
+    {
+      return 0;
+    }
+    auto endIndex = shmImpl_->ringBuffer_ptr_->getEndIndex();
+
+    //Claim [firstIndex, lastIndex) by moving stay index once. Recycled messages restart from start index.
+    auto stayIndex = stayIndex_.load(std::memory_order_acquire);
+    uint64_t firstIndex;
+    uint64_t lastIndex;
+    do
+    {
+      firstIndex = (stayIndex == SHM_INVALID_SEQUENCE || stayIndex < startIndex) ? startIndex : stayIndex;
+      if (firstIndex >= endIndex)
+      {
+        return 0;
+      }
+      lastIndex = std::min<uint64_t>(endIndex, firstIndex + maxCount);
+    } while (stayIndex_.compare_exchange_weak(stayIndex, lastIndex, std::memory_order_acq_rel, std::memory_order_acquire) == false);
+    if (stayIndex != SHM_INVALID_SEQUENCE && stayIndex < startIndex)
+    {
+      LOG_WARN("sequence gap detected, {} messages are lost", startIndex - stayIndex);
+    }
+    updateStartMsgAndIndex(block, startIndex);
+
+    uint32_t readCount = 0;
+    for (auto msgIndex = firstIndex; msgIndex < lastIndex; msgIndex++)
+    {
+      uint32_t data_len = 0;
+      if (shmImpl_->ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_FAIL)
+      {
+        LOG_WARN("message {} is recycled before batch read", msgIndex);
+        continue;
+      }
+      if (buffer.size() < block.msgSize_)
+      {
+        buffer.resize(block.msgSize_);
+      }
+      if (shmImpl_->readMsg(buffer.data(), data_len, msgIndex, block) == PROCESS_FAIL)
+      {
+        continue;
+      }
+      callback(buffer.data(), data_len);
+      updateLastMsg(block);
+      readCount++;
+    }
+    publishReaderCursor();
+    return readCount;
+  }
+
+  void reliableTpController_shm::attachReaderCursor()
+  {
+    std::call_once(readerOnceFlag_, [this]() {
+      readerId_ = shmImpl_->ringBuffer_ptr_->registerReader();
+    });
+    if (shmImpl_->ringBuffer_ptr_->reviveReader(readerId_) == true)
+    {
+      LOG_WARN("reader is evicted by publisher, restart from the oldest message");
+      stayIndex_.store(SHM_INVALID_SEQUENCE, std::memory_order_release);
+    }
+  }
+
+  void reliableTpController_shm::publishReaderCursor()
+  {
+    shmImpl_->ringBuffer_ptr_->updateReaderCursor(readerId_, stayIndex_.load(std::memory_order_acquire));
+  }
+
+  template<typename FUNC_T>
+  bool reliableTpController_shm::consumeMsg(FUNC_T &&consumeFunc, abstractTransport::BLOCKING_TYPE block_type)
   {
     bool semaphoreInvokeFlag = false;
+    attachReaderCursor();
 
-    auto  subscribeLatestMsg_func = [this, &read_data, &data_len, &semaphoreInvokeFlag]() {
+    auto  subscribeLatestMsg_func = [this, &consumeFunc, &semaphoreInvokeFlag]() {
       //Solve shared memory latency problem.
       std::function<void()>   waitValidFunc = [this, &semaphoreInvokeFlag]() {
         uint32_t waitSharedMemoryValidTime = 20;
@@ -151,7 +329,7 @@ namespace dawn
       };
 
       shmIndexRingBuffer::ringBufferIndexBlockType startIndexBlock;
-      uint32_t   startIndex;
+      uint64_t   startIndex;
       bool result = false;
       if (shmImpl_->requireStartMsg(startIndex, startIndexBlock) == PROCESS_SUCCESS)
       {
@@ -159,21 +337,17 @@ namespace dawn
         {
           case tpController::MSG_FRESHNESS::NEW_ROUND:
             {
-              if (shmImpl_->watchRingBuffer() == PROCESS_SUCCESS)
+              uint64_t     startIndex;
+              if (shmImpl_->ringBuffer_ptr_->getStartBuffer(startIndexBlock, startIndex) == PROCESS_SUCCESS)
               {
-                uint32_t     startIndex;
-                if (shmImpl_->ringBuffer_ptr_->getStartBuffer(startIndexBlock, startIndex) == PROCESS_SUCCESS)
+                if (consumeFunc(startIndex, startIndexBlock) == PROCESS_SUCCESS)
                 {
-                  if (shmImpl_->readBuffer(read_data, data_len, startIndexBlock.shmMsgIndex_, startIndexBlock.msgSize_) == PROCESS_SUCCESS)
-                  {
-                    updateStartMsgAndIndex(startIndexBlock, startIndex);
-                    updateLastMsg(startIndexBlock);
-                    uint32_t msgIndex;
-                    updateStayIndex(msgIndex, startIndex + 1);
-                    result = true;
-                  }
+                  updateStartMsgAndIndex(startIndexBlock, startIndex);
+                  updateLastMsg(startIndexBlock);
+                  uint64_t msgIndex;
+                  updateStayIndex(msgIndex, startIndex + 1);
+                  result = true;
                 }
-                shmImpl_->stopWatchRingBuffer();
               }
             }
             break;
@@ -181,46 +355,34 @@ namespace dawn
           case tpController::MSG_FRESHNESS::FRESH:
             {
               updateStartMsgAndIndex(startIndexBlock, startIndex);
-              if (shmImpl_->watchRingBuffer() == PROCESS_SUCCESS)
+              waitValidFunc();
+              uint64_t    msgIndex;
+              shmIndexRingBuffer::ringBufferIndexBlockType  block;
+              if (updateStayIndex(msgIndex) == PROCESS_SUCCESS)
               {
-                waitValidFunc();
-                uint32_t    msgIndex;
-                shmIndexRingBuffer::ringBufferIndexBlockType  block;
-                if (updateStayIndex(msgIndex) == PROCESS_SUCCESS)
+                if (shmImpl_->ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS && \
+                  consumeFunc(msgIndex, block) == PROCESS_SUCCESS)
                 {
-                  if (shmImpl_->ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS)
-                  {
-                    if (shmImpl_->readBuffer(read_data, data_len, block.shmMsgIndex_, block.msgSize_) == PROCESS_SUCCESS)
-                    {
-                      updateLastMsg(block);
-                      result = true;
-                    }
-                  }
+                  updateLastMsg(block);
+                  result = true;
                 }
-                shmImpl_->stopWatchRingBuffer();
               }
             }
             break;
 
           case tpController::MSG_FRESHNESS::STALE:
             {
-              if (shmImpl_->watchRingBuffer() == PROCESS_SUCCESS)
+              waitValidFunc();
+              uint64_t    msgIndex;
+              shmIndexRingBuffer::ringBufferIndexBlockType  block;
+              if (updateStayIndex(msgIndex) == PROCESS_SUCCESS)
               {
-                waitValidFunc();
-                uint32_t    msgIndex;
-                shmIndexRingBuffer::ringBufferIndexBlockType  block;
-                if (updateStayIndex(msgIndex) == PROCESS_SUCCESS)
+                if (shmImpl_->ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS && \
+                  consumeFunc(msgIndex, block) == PROCESS_SUCCESS)
                 {
-                  if (shmImpl_->ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS)
-                  {
-                    if (shmImpl_->readBuffer(read_data, data_len, block.shmMsgIndex_, block.msgSize_) == PROCESS_SUCCESS)
-                    {
-                      updateLastMsg(block);
-                      result = true;
-                    }
-                  }
+                  updateLastMsg(block);
+                  result = true;
                 }
-                shmImpl_->stopWatchRingBuffer();
               }
             }
             break;
@@ -230,6 +392,10 @@ namespace dawn
         }
       }
 
+      if (result == true)
+      {
+        publishReaderCursor();
+      }
       return result;
     };
 
@@ -237,22 +403,8 @@ namespace dawn
     {
       return PROCESS_SUCCESS;
     }
-    if (block_type == abstractTransport::BLOCKING_TYPE::BLOCK)
-    {
-      semaphoreInvokeFlag = true;
-      shmImpl_->channel_ptr_->waitNotify(subscribeLatestMsg_func);
-      return PROCESS_SUCCESS;
-    }
-    else
-    {
-      semaphoreInvokeFlag = true;
-      auto result = shmImpl_->channel_ptr_->tryWaitNotify(subscribeLatestMsg_func);
-      if (result == false)
-      {
-        return PROCESS_FAIL;
-      }
-    }
-    return PROCESS_FAIL;
+    semaphoreInvokeFlag = true;
+    return shmImpl_->waitMsg(subscribeLatestMsg_func, block_type, qosCfg_.spinBudgetUs_);
   }
 
   qosCfg::QOS_TYPE reliableTpController_shm::getQosType()
@@ -260,19 +412,29 @@ namespace dawn
     return qosCfg_.qosType_;
   }
 
-  tpController::MSG_FRESHNESS reliableTpController_shm::tasteMsgAtStartIndex(shmIndexRingBuffer::ringBufferIndexBlockType &startMsg, uint32_t startRingBufferIndex)
+  std::shared_ptr<shmChannel> reliableTpController_shm::getChannel()
+  {
+    return shmImpl_->channel_ptr_;
+  }
+
+  tpController::MSG_FRESHNESS reliableTpController_shm::tasteMsgAtStartIndex(shmIndexRingBuffer::ringBufferIndexBlockType &startMsg, uint64_t startRingBufferIndex)
   {
     std::shared_lock        lock(startMsgMutex_);
-    if (recordStartIndex_ != SHM_INVALID_INDEX)
+    if (recordStartIndex_ != SHM_INVALID_SEQUENCE)
     {
-      if (recordStartIndex_ != startRingBufferIndex)
+      auto stayIndex = stayIndex_.load(std::memory_order_acquire);
+      if (stayIndex == SHM_INVALID_SEQUENCE || stayIndex < startRingBufferIndex)
       {
-        return tpController::MSG_FRESHNESS::FRESH;
+        /// @note Messages this reader stays at are recycled, restart from start index.
+        if (stayIndex != SHM_INVALID_SEQUENCE)
+        {
+          LOG_WARN("sequence gap detected, {} messages are lost", startRingBufferIndex - stayIndex);
+        }
+        return tpController::MSG_FRESHNESS::NEW_ROUND;
       }
-      else if (recordStartIndex_ == startRingBufferIndex && startMsg.timeStamp_ != startBlock_.timeStamp_)
+      else if (recordStartIndex_ != startRingBufferIndex)
       {
-        /// @todo Check msg is timeout by checking time stamp.
-        return tpController::MSG_FRESHNESS::NEW_ROUND;
+        return tpController::MSG_FRESHNESS::FRESH;
       }
       else
       {
@@ -287,21 +449,12 @@ namespace dawn
   }
 
 
-  tpController::MSG_FRESHNESS reliableTpController_shm::tasteMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint32_t ringBufferIndex)
+  tpController::MSG_FRESHNESS reliableTpController_shm::tasteMsg(shmIndexRingBuffer::ringBufferIndexBlockType &msg, uint64_t ringBufferIndex)
   {
     std::shared_lock        lock(lastMsgMutex_);
-    if (stayIndex_ != SHM_INVALID_INDEX)
+    if (stayIndex_ != SHM_INVALID_SEQUENCE)
     {
-      if (msg.timeStamp_ > lastBlock_.timeStamp_)
-      {
-        return tpController::MSG_FRESHNESS::FRESH;
-      }
-      else if (msg.timeStamp_ == lastBlock_.timeStamp_ && ringBufferIndex == stayIndex_)
-      {
-        // This scenario happens when time stamp is in next period.
-        return tpController::MSG_FRESHNESS::FRESH;
-      }
-      else if (msg.timeStamp_ < lastBlock_.timeStamp_ && ringBufferIndex == stayIndex_)
+      if (ringBufferIndex >= stayIndex_)
       {
         return tpController::MSG_FRESHNESS::FRESH;
       }
@@ -320,10 +473,10 @@ namespace dawn
     return PROCESS_SUCCESS;
   }
 
-  bool reliableTpController_shm::updateStartMsgAndIndex(shmIndexRingBuffer::ringBufferIndexBlockType &block, uint32_t ringBufferIndex)
+  bool reliableTpController_shm::updateStartMsgAndIndex(shmIndexRingBuffer::ringBufferIndexBlockType &block, uint64_t ringBufferIndex)
   {
     std::unique_lock       shared_lock(startMsgMutex_);
-    if (ringBufferIndex != recordStartIndex_ && block.timeStamp_ != startBlock_.timeStamp_)
+    if (ringBufferIndex != recordStartIndex_)
     {
       std::memcpy(&startBlock_, &block, sizeof(shmIndexRingBuffer::ringBufferIndexBlockType));
       recordStartIndex_ = ringBufferIndex;
@@ -335,7 +488,7 @@ namespace dawn
     }
   }
 
-  bool reliableTpController_shm::updateStayIndex(uint32_t &updatedIndex)
+  bool reliableTpController_shm::updateStayIndex(uint64_t &updatedIndex)
   {
     auto oldIndex = stayIndex_.load(std::memory_order_acquire);
 
@@ -364,7 +517,7 @@ namespace dawn
     }
   }
 
-  bool reliableTpController_shm::updateStayIndex(uint32_t &updatedIndex, uint32_t ringBufferIndex)
+  bool reliableTpController_shm::updateStayIndex(uint64_t &updatedIndex, uint64_t ringBufferIndex)
   {
     auto oldIndex = stayIndex_.load(std::memory_order_acquire);
 
@@ -1,7 +1,12 @@
 #ifndef _SHM_TRANSPORT_IMPL_H_
 #define _SHM_TRANSPORT_IMPL_H_
 
+#include <chrono>
+#include <thread>
+
 #include "transport.h"
+#include "shmReclaimer.h"
+#include "common/baseOperator.h"
 
 namespace dawn
 {
@@ -11,17 +16,37 @@ namespace dawn
   {
     friend struct efficientTpController_shm;
     friend struct reliableTpController_shm;
-    shmTransportImpl(std::string_view identity) :
+    friend struct shmReclaimer;
+    shmTransportImpl(std::string_view identity, const qosCfg &config = qosCfg()) :
       identity_(identity),
-      lockMsgOwns_(0)
+      fullPolicy_(config.fullPolicy_),
+      fullTimeoutUs_(config.fullTimeoutUs_),
+      allocTimeoutUs_(config.allocTimeoutUs_),
+      lifespanNs_(static_cast<uint64_t>(config.lifespanUs_) * 1000),
+      historyDepth_(config.historyDepth_)
     {
-      channel_ptr_ = std::make_shared<shmChannel>(CHANNEL_PREFIX + identity_);
-      shmPool_ptr_ = std::make_shared<shmMsgPool>();
-      ringBuffer_ptr_ = std::make_shared<shmIndexRingBuffer>(RING_BUFFER_PREFIX + identity_);
-      msgShm_raw_ptr_ = shmPool_ptr_->getMsgRawBuffer();
+      shmTopicSegment segment(identity_, config);
+      channel_ptr_ = segment.getChannel();
+      ringBuffer_ptr_ = segment.getRingBuffer();
+      shmPoolVec_ = segment.getPoolVec();
+      if (shmPoolVec_.empty() == true)
+      {
+        shmPoolVec_.emplace_back(shmMsgPool::getGlobalPool());
+      }
+      if (lifespanNs_ != 0 || historyDepth_ != 0)
+      {
+        reclaimer_ptr_ = shmReclaimer::getReclaimer();
+        reclaimer_ptr_->registerTopic(this);
+      }
     }
 
-    ~shmTransportImpl() = default;
+    ~shmTransportImpl()
+    {
+      if (reclaimer_ptr_)
+      {
+        reclaimer_ptr_->unregisterTopic(this);
+      }
+    }
 
     /// @brief Write data to data space.
     ///        Property: thread safe
@@ -30,50 +55,212 @@ namespace dawn
     /// @return 
     bool baseWrite(const void *write_data, const uint32_t data_len)
     {
-      auto msg_vec = retryRequireMsgShm(data_len);
+      iovec iov{const_cast<void*>(write_data), data_len};
+      return baseWrite(&iov, 1);
+    }
 
-      if (msg_vec.size() == 0)
+    /// @brief Write a message gathered from fragments to data space.
+    ///        Property: thread safe
+    /// @param iov
+    /// @param iovcnt
+    /// @return PROCESS_SUCCESS if write successfully.
+    bool baseWrite(const iovec *iov, int iovcnt)
+    {
+      uint64_t data_len = 0;
+      for (int i = 0; i < iovcnt; i++)
       {
-        LOG_ERROR("can not allocate enough shm");
+        data_len += iov[i].iov_len;
+      }
+      if (iovcnt <= 0 || data_len > UINT32_MAX)
+      {
+        LOG_ERROR("can not write {} fragments of {} bytes", iovcnt, data_len);
         return PROCESS_FAIL;
       }
 
-      msgType   *prev_msg = nullptr;
-      uint32_t written_len = 0;
-      auto wait2writeLen = data_len;
+      shmLoanedMsg loanedMsg;
+      if (loanMsg(static_cast<uint32_t>(data_len), loanedMsg) == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
 
-      /// @note Write data to shm
-      for (auto msgIndex : msg_vec)
+      /// @note Write every fragment straight to shm extents.
+      int iovIndex = 0;
+      size_t iovOffset = 0;
+      for (auto &fragment : loanedMsg.fragments_)
       {
-        auto msgBlock = FIND_SHARE_MEM_BLOCK_ADDR(msgShm_raw_ptr_, msgIndex);
-        auto msgBlockIns = new(msgBlock) msgType;
-        if (wait2writeLen <= SHM_BLOCK_CONTENT_SIZE)
+        for (size_t written_len = 0; written_len < fragment.iov_len;)
         {
-          std::memcpy(msgBlockIns->content_, (char*)write_data + written_len, wait2writeLen);
+          while (iovOffset == iov[iovIndex].iov_len)
+          {
+            iovIndex++;
+            iovOffset = 0;
+          }
+          auto copyLen = std::min(fragment.iov_len - written_len, iov[iovIndex].iov_len - iovOffset);
+          std::memcpy((char*)fragment.iov_base + written_len, (const char*)iov[iovIndex].iov_base + iovOffset, copyLen);
+          written_len += copyLen;
+          iovOffset += copyLen;
         }
-        else
+      }
+
+      return publishLoanedMsg(loanedMsg);
+    }
+
+    /// @brief Write a batch of messages with one ring buffer claim and one notification.
+    ///        Property: thread safe
+    /// @param msgs every iovec is one message.
+    /// @param msgNum
+    /// @return PROCESS_SUCCESS if all messages are published. Otherwise messages which aren't published are
+    ///         given back, only a batch abandoned by a stalled commit can be published in part.
+    bool baseWriteBatch(const iovec *msgs, uint32_t msgNum)
+    {
+      if (msgNum == 0 || msgNum > ringBuffer_ptr_->getRingDepth())
+      {
+        LOG_ERROR("can not write a batch of {} messages", msgNum);
+        return PROCESS_FAIL;
+      }
+
+      std::vector<uint32_t> dataSizeVec(msgNum);
+      uint32_t maxDataSize = 0;
+      for (uint32_t i = 0; i < msgNum; i++)
+      {
+        if (msgs[i].iov_len == 0 || msgs[i].iov_len > UINT32_MAX)
         {
-          std::memcpy(msgBlockIns->content_, (char*)write_data + written_len, SHM_BLOCK_CONTENT_SIZE);
-          wait2writeLen -= SHM_BLOCK_CONTENT_SIZE;
-          written_len += SHM_BLOCK_CONTENT_SIZE;
+          LOG_ERROR("can not write message {} of {} bytes in batch", i, msgs[i].iov_len);
+          return PROCESS_FAIL;
         }
+        dataSizeVec[i] = static_cast<uint32_t>(msgs[i].iov_len);
+        maxDataSize = std::max(maxDataSize, dataSizeVec[i]);
+      }
 
-        if (prev_msg != nullptr)
+      //Try to take the whole batch from one run of a pool, retiring up to msgNum old messages to make room.
+      //Otherwise allocate messages one by one.
+      shmIndexRingBuffer::ringBufferIndexBlockType unpublishedBlock{};
+      unpublishedBlock.sequence_ = SHM_INVALID_SEQUENCE;
+      std::vector<shmIndexRingBuffer::ringBufferIndexBlockType> blockVec(msgNum, unpublishedBlock);
+      std::vector<uint32_t> msgIndexVec;
+      auto poolIndexVec = selectShmPool(maxDataSize);
+      for (uint32_t i = 0; i <= msgNum && msgIndexVec.empty(); i++)
+      {
+        for (auto poolIndex : poolIndexVec)
         {
-          prev_msg->next_ = msgIndex;
-          prev_msg = msgBlockIns;
+          msgIndexVec = shmPoolVec_[poolIndex]->requireMsgShmBatch(dataSizeVec);
+          if (msgIndexVec.empty() == false)
+          {
+            for (auto &block : blockVec)
+            {
+              block.poolIndex_ = poolIndex;
+            }
+            break;
+          }
         }
-        else
+        if (msgIndexVec.empty() && recycleExpireMsg() == PROCESS_FAIL)
+        {
+          break;
+        }
+      }
+      for (uint32_t i = 0; msgIndexVec.size() < msgNum; i++)
+      {
+        auto msg_vec = retryRequireMsgShm(dataSizeVec[i], blockVec[i].poolIndex_);
+        if (msg_vec.empty() == true)
+        {
+          LOG_ERROR("can not allocate enough shm for batch");
+          recycleMsgBatch(msgIndexVec, blockVec);
+          return PROCESS_FAIL;
+        }
+        msgIndexVec.emplace_back(msg_vec.front());
+      }
+
+      for (uint32_t i = 0; i < msgNum; i++)
+      {
+        auto write_data = static_cast<const char*>(msgs[i].iov_base);
+        walkMsgExtent(*shmPoolVec_[blockVec[i].poolIndex_], msgIndexVec[i], dataSizeVec[i], [&write_data](char *content, uint32_t contentLen) {
+          std::memcpy(content, write_data, contentLen);
+          write_data += contentLen;
+        });
+        blockVec[i].shmMsgIndex_ = msgIndexVec[i];
+        blockVec[i].msgSize_ = dataSizeVec[i];
+      }
+
+      uint64_t firstPosition;
+      auto result = ringBuffer_ptr_->moveEndIndex(blockVec.data(), msgNum, firstPosition);
+      //Best effort to publish the batch.
+      for (uint32_t i = 0; i < msgNum && result == shmIndexRingBuffer::PROCESS_RESULT::BUFFER_FILL; i++)
+      {
+        if (recycleExpireMsg() == PROCESS_FAIL)
         {
-          prev_msg = msgBlockIns;
+          break;
         }
+        result = ringBuffer_ptr_->moveEndIndex(blockVec.data(), msgNum, firstPosition);
+      }
+      if (result != shmIndexRingBuffer::PROCESS_RESULT::SUCCESS)
+      {
+        LOG_ERROR("can not write batch to ring buffer");
+        recycleMsgBatch(msgIndexVec, blockVec);
+        return PROCESS_FAIL;
+      }
+
+      channel_ptr_->notifyAll();
+      return PROCESS_SUCCESS;
+    }
+
+    /// @brief Allocate a chain of shm blocks for a message and expose them as writable fragments.
+    ///        Property: thread safe
+    /// @param data_len
+    /// @param loanedMsg
+    /// @return PROCESS_SUCCESS if shm is enough.
+    bool loanMsg(const uint32_t data_len, shmLoanedMsg &loanedMsg)
+    {
+      if (data_len == 0)
+      {
+        LOG_ERROR("can not loan empty message");
+        return PROCESS_FAIL;
+      }
+
+      uint32_t poolIndex = 0;
+      auto msg_vec = retryRequireMsgShm(data_len, poolIndex);
+
+      if (msg_vec.size() == 0)
+      {
+        LOG_ERROR("can not allocate enough shm");
+        return PROCESS_FAIL;
+      }
+
+      loanedMsg.release();
+      loanedMsg.fragments_.reserve(msg_vec.size());
+
+      //Extents from pool are already linked in order.
+      walkMsgExtent(*shmPoolVec_[poolIndex], msg_vec.front(), data_len, [&loanedMsg](char *content, uint32_t contentLen) {
+        loanedMsg.fragments_.emplace_back(iovec{content, contentLen});
+      });
+
+      loanedMsg.size_ = data_len;
+      loanedMsg.poolIndex_ = poolIndex;
+      loanedMsg.msgIndexVec_ = std::move(msg_vec);
+      loanedMsg.shmPool_ptr_ = shmPoolVec_[poolIndex];
+      return PROCESS_SUCCESS;
+    }
+
+    /// @brief Publish a loaned message to ring buffer and notify subscribers.
+    ///        Property: thread safe
+    /// @param loanedMsg On success, blocks are owned by ring buffer and loanedMsg becomes invalid.
+    /// @return PROCESS_SUCCESS if publish successfully.
+    bool publishLoanedMsg(shmLoanedMsg &loanedMsg)
+    {
+      if (loanedMsg.valid() == false || loanedMsg.poolIndex_ >= shmPoolVec_.size() || \
+        loanedMsg.shmPool_ptr_ != shmPoolVec_[loanedMsg.poolIndex_])
+      {
+        LOG_ERROR("publish a invalid loaned message");
+        return PROCESS_FAIL;
       }
 
       /// @note Publish msg to ring buffer
-      if (publishMsg(msg_vec[0], data_len) == PROCESS_FAIL)
+      if (publishMsg(loanedMsg.msgIndexVec_[0], loanedMsg.size_, loanedMsg.poolIndex_) == PROCESS_FAIL)
       {
         return PROCESS_FAIL;
       }
+      loanedMsg.msgIndexVec_.clear();
+      loanedMsg.fragments_.clear();
+      loanedMsg.size_ = 0;
 
       channel_ptr_->notifyAll();
 
@@ -90,60 +277,144 @@ namespace dawn
     {
       auto subscribeLatestMsg_func = [this, &read_data, &data_len]() {
         shmIndexRingBuffer::ringBufferIndexBlockType block;
-        bool result = false;
-        if (subscribeLatestMsgAndSharableLock(block) == PROCESS_SUCCESS)
+        uint64_t    ringBufferIndex;
+        if (subscribeLatestMsg(block, ringBufferIndex) == PROCESS_SUCCESS)
         {
-          if (readBuffer(read_data, data_len, block.shmMsgIndex_, block.msgSize_) == PROCESS_SUCCESS)
-          {
-            result = true;
-          }
-          stopWatchRingBuffer();
+          return readMsg(read_data, data_len, ringBufferIndex, block) == PROCESS_SUCCESS;
         }
-        return result;
+        return false;
       };
 
-      //Block until message arrival
-      if (block_type == abstractTransport::BLOCKING_TYPE::BLOCK)
+      return waitMsg(subscribeLatestMsg_func, block_type, SHM_SPIN_BUDGET_US);
+    }
+
+    /// @brief Wait until consume function takes a message.
+    /// @param func consume function, it returns true once a message is taken.
+    /// @param block_type
+    /// @param spinBudgetUs spin time of ADAPTIVE before parking.
+    /// @return PROCESS_SUCCESS if a message is taken.
+    template<typename FUNC_T>
+    bool waitMsg(FUNC_T &&func, abstractTransport::BLOCKING_TYPE block_type, uint32_t spinBudgetUs)
+    {
+      switch (block_type)
       {
-        channel_ptr_->waitNotify();
-        return subscribeLatestMsg_func();
+        case abstractTransport::BLOCKING_TYPE::BLOCK:
+          channel_ptr_->waitNotify(func);
+          return PROCESS_SUCCESS;
+
+        case abstractTransport::BLOCKING_TYPE::BUSY_POLL:
+          while (spinWaitMsg(func, std::chrono::steady_clock::time_point::max()) == false)
+          {
+          }
+          return PROCESS_SUCCESS;
+
+        case abstractTransport::BLOCKING_TYPE::ADAPTIVE:
+          if (spinWaitMsg(func, std::chrono::steady_clock::now() + std::chrono::microseconds(spinBudgetUs)) == false)
+          {
+            channel_ptr_->waitNotify(func);
+          }
+          return PROCESS_SUCCESS;
+
+        default:
+          return channel_ptr_->tryWaitNotify(func);
       }
-      else
+    }
+
+    /// @brief Spin on end index of ring buffer and try func whenever a message is published.
+    /// @note Func is also retried every SHM_SPIN_RETRY_NUM spins, in case its message was committed before spinning.
+    /// @return false if deadline passes without taking a message.
+    template<typename FUNC_T>
+    bool spinWaitMsg(FUNC_T &&func, std::chrono::steady_clock::time_point deadline)
+    {
+      auto endIndex = ringBuffer_ptr_->getEndIndex();
+      for (uint32_t i = 1;; i++)
       {
-        if (channel_ptr_->tryWaitNotify() == false)
+        auto currentEndIndex = ringBuffer_ptr_->getEndIndex();
+        if (currentEndIndex != endIndex || i % SHM_SPIN_RETRY_NUM == 0)
         {
-          return PROCESS_FAIL;
+          endIndex = currentEndIndex;
+          if (func())
+          {
+            return true;
+          }
+          if (std::chrono::steady_clock::now() >= deadline)
+          {
+            return false;
+          }
         }
+        cpuRelax();
+      }
+    }
 
-        if (subscribeLatestMsg_func() == true)
-        {
-          return PROCESS_SUCCESS;
-        }
-        else
-        {
-          return PROCESS_FAIL;
-        }
+    /// @brief Pin message described by index block and expose its blocks without copying.
+    /// @param ringBufferIndex sequence of block in ring buffer.
+    /// @param block
+    /// @param borrowedMsg
+    /// @return PROCESS_SUCCESS if message is pinned before it is recycled.
+    bool borrowMsg(uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block, shmBorrowedMsg &borrowedMsg)
+    {
+      if (block.msgSize_ == 0 || block.poolIndex_ >= shmPoolVec_.size())
+      {
+        return PROCESS_FAIL;
+      }
+      auto &shmPool_ptr = shmPoolVec_[block.poolIndex_];
+      if (shmPool_ptr->pinMsgShm(block.shmMsgIndex_) == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
+
+      /// @note Message pinned before it is retired is alive until unpinned.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (checkMsgIndexValid(ringBufferIndex) == false)
+      {
+        shmPool_ptr->unpinMsgShm(block.shmMsgIndex_);
+        return PROCESS_FAIL;
       }
 
+      borrowedMsg.release();
+      auto walkLen = walkMsgExtent(*shmPool_ptr, block.shmMsgIndex_, block.msgSize_, [&borrowedMsg](char *content, uint32_t contentLen) {
+        borrowedMsg.fragments_.emplace_back(iovec{content, contentLen});
+      });
+
+      borrowedMsg.size_ = block.msgSize_;
+      borrowedMsg.headIndex_ = block.shmMsgIndex_;
+      borrowedMsg.shmPool_ptr_ = shmPool_ptr;
+      if (walkLen != block.msgSize_)
+      {
+        LOG_WARN("message size is truncated {}, actual size {}", walkLen, block.msgSize_);
+        borrowedMsg.release();
+        return PROCESS_FAIL;
+      }
+      return PROCESS_SUCCESS;
+    }
+
+    bool readSpecificIndexMsg(void *read_data, uint32_t &data_len, uint64_t msgIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block)
+    {
+      if (ringBuffer_ptr_->getSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS)
+      {
+        return readMsg(read_data, data_len, msgIndex, block);
+      }
       return PROCESS_FAIL;
     }
 
-    bool readSpecificIndexMsg(void *read_data, uint32_t &data_len, uint32_t msgIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block)
+    /// @brief Copy message described by index block and validate it is not recycled during copy.
+    /// @param read_data
+    /// @param data_len
+    /// @param ringBufferIndex sequence of block in ring buffer.
+    /// @param block
+    /// @return PROCESS_SUCCESS if the copied message is consistent.
+    bool readMsg(void *read_data, uint32_t &data_len, uint64_t ringBufferIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block)
     {
-      bool result = false;
-      if (ringBuffer_ptr_->watchSpecificIndexBuffer(msgIndex, block) == PROCESS_SUCCESS)
+      if (readBuffer(read_data, data_len, block) == PROCESS_FAIL)
       {
-        if (readBuffer(read_data, data_len, block.shmMsgIndex_, block.msgSize_) == PROCESS_SUCCESS)
-        {
-          result = true;
-        }
-        ringBuffer_ptr_->stopWatchSpecificIndexBuffer();
+        return PROCESS_FAIL;
       }
-      if (result == true)
+      if (checkMsgIndexValid(ringBufferIndex) == false)
       {
-        return PROCESS_SUCCESS;
+        LOG_WARN("message {} is recycled while reading", ringBufferIndex);
+        return PROCESS_FAIL;
       }
-      return PROCESS_FAIL;
+      return PROCESS_SUCCESS;
     }
 
     bool wait()
@@ -152,12 +423,13 @@ namespace dawn
     }
 
     protected:
-    bool publishMsg(uint32_t msgIndex, uint32_t msgSize)
+    bool publishMsg(uint32_t msgIndex, uint32_t msgSize, uint32_t poolIndex)
     {
       shmIndexRingBuffer::ringBufferIndexBlockType ringBufferBlock;
-      uint32_t      storePosition;
+      uint64_t      storePosition;
       ringBufferBlock.shmMsgIndex_ = msgIndex;
       ringBufferBlock.msgSize_ = msgSize;
+      ringBufferBlock.poolIndex_ = poolIndex;
       auto result = ringBuffer_ptr_->moveEndIndex(ringBufferBlock, storePosition);
       if (result == shmIndexRingBuffer::PROCESS_RESULT::FAIL)
       {
@@ -169,7 +441,7 @@ namespace dawn
         //Best effort to publish the message.
         recycleExpireMsg();
         result = ringBuffer_ptr_->moveEndIndex(ringBufferBlock, storePosition);
-        if (result == shmIndexRingBuffer::PROCESS_RESULT::FAIL)
+        if (result != shmIndexRingBuffer::PROCESS_RESULT::SUCCESS)
         {
           LOG_ERROR("can not write to ring buffer");
           return PROCESS_FAIL;
@@ -185,150 +457,290 @@ namespace dawn
       return PROCESS_SUCCESS;
     }
 
-    /// @brief Read the latest index block from ring buffer and will shared lock ring buffer.
-    ///        Need to use unlockRingBuffer() to unlock end index of ring buffer.
+    /// @brief Read the latest index block from ring buffer.
     /// @param block 
-    /// @return PROCESS_SUCCESS if read index block successfully and will lock end index, otherwise return PROCESS_FAIL.
-    bool subscribeLatestMsgAndSharableLock(shmIndexRingBuffer::ringBufferIndexBlockType &block)
+    /// @param ringBufferIndex sequence of the latest block.
+    /// @return PROCESS_SUCCESS if read index block successfully, otherwise return PROCESS_FAIL.
+    bool subscribeLatestMsg(shmIndexRingBuffer::ringBufferIndexBlockType &block, uint64_t &ringBufferIndex)
     {
-      if (watchRingBuffer() == PROCESS_SUCCESS)
-      {
-        if (ringBuffer_ptr_->getLatestBuffer(block) == PROCESS_FAIL)
-        {
-          stopWatchRingBuffer();
-          return PROCESS_FAIL;
-        }
-        return PROCESS_SUCCESS;
-      }
-      return PROCESS_FAIL;
+      return ringBuffer_ptr_->getLatestBuffer(block, ringBufferIndex);
     }
 
-    bool checkMsgIndexValid(uint32_t msgIndex)
+    bool checkMsgIndexValid(uint64_t msgIndex)
     {
       return ringBuffer_ptr_->checkIndexValid(msgIndex);
     }
 
-    /// @brief shared lock ring buffer.
-    /// @return PROCESS_SUCCESS if lock ring buffer successfully, otherwise return PROCESS_FAIL.
-    bool watchRingBuffer()
+    /// @brief Read data at ring buffer start position.
+    /// @param msgIndex position
+    /// @param block content
+    /// @return PROCESS_SUCCESS if read data successfully, otherwise return PROCESS_FAIL.
+    bool requireStartMsg(uint64_t &msgIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block)
     {
-      std::unique_lock<std::shared_mutex>     lock(lockMsgMutex_);
-      if (lockMsgOwns_.load(std::memory_order_acquire) == 0)
-      {
-        if (ringBuffer_ptr_->sharedLockBuffer() == PROCESS_SUCCESS)
-        {
-          lockMsgOwns_++;
-          return PROCESS_SUCCESS;
-        }
-        else
-        {
-          return PROCESS_FAIL;
-        }
-      }
-      else
-      {
-        lockMsgOwns_++;
-        return PROCESS_SUCCESS;
-      }
+      return ringBuffer_ptr_->getStartIndex(msgIndex, block);
     }
 
-    /// @brief Unlock end index of ring buffer.
-    /// @return void
-    void stopWatchRingBuffer()
+    /// @brief Order of pools to try for a message.
+    ///        The smallest pool whose one block holds the message goes first, then larger pools,
+    ///        then smaller pools which hold it as an extent.
+    std::vector<uint32_t> selectShmPool(uint32_t data_size)
     {
-      std::unique_lock<std::shared_mutex>     lock(lockMsgMutex_);
-      if (lockMsgOwns_.load(std::memory_order_acquire) == 1)
+      std::vector<uint32_t> poolIndexVec;
+      poolIndexVec.reserve(shmPoolVec_.size());
+      uint32_t fitIndex = 0;
+      while (fitIndex + 1 < shmPoolVec_.size() && shmPoolVec_[fitIndex]->getBlockContentSize() < data_size)
       {
-        if (ringBuffer_ptr_->sharedUnlockBuffer() == PROCESS_SUCCESS)
-        {
-          lockMsgOwns_--;
-        }
+        fitIndex++;
       }
-      else
+      for (uint32_t i = fitIndex; i < shmPoolVec_.size(); i++)
       {
-        lockMsgOwns_--;
+        poolIndexVec.emplace_back(i);
       }
+      for (uint32_t i = fitIndex; i > 0; i--)
+      {
+        poolIndexVec.emplace_back(i - 1);
+      }
+      return poolIndexVec;
     }
 
-    /// @brief Read data at ring buffer start position.
-    /// @param msgIndex position
-    /// @param block content
-    /// @return PROCESS_SUCCESS if read data successfully, otherwise return PROCESS_FAIL.
-    bool requireStartMsg(uint32_t &msgIndex, shmIndexRingBuffer::ringBufferIndexBlockType &block)
-    {
-      return ringBuffer_ptr_->getStartIndex(msgIndex, block);
-    }
-
-    std::vector<uint32_t> retryRequireMsgShm(uint32_t data_size)
+    /// @brief Allocate a message from pools in order of selectShmPool, recycling the oldest messages when pools are full.
+    ///        With allocTimeoutUs_, publisher then keeps recycling and parks on free channels of pools until
+    ///        readers give blocks back or deadline passes.
+    /// @param data_size
+    /// @param poolIndex pool which holds the message.
+    /// @return head blocks of message, empty if no pool holds it in time.
+    std::vector<uint32_t> retryRequireMsgShm(uint32_t data_size, uint32_t &poolIndex)
     {
-      int retryTime = 3;
-      for (int i = 0; i < retryTime; i++)
+      constexpr int retryTime = 3;
+      std::vector<uint32_t> msgVec;
+      auto poolIndexVec = selectShmPool(data_size);
+      std::vector<shmChannel*> channelVec;
+      std::vector<uint32_t> sequenceVec;
+      bool isSpaceWaiter = false;
+      bool isAllocated = false;
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(allocTimeoutUs_);
+      for (int i = 0;; i++)
       {
-        try
+        bool waitSpace = (i >= retryTime && allocTimeoutUs_ != 0);
+        if (waitSpace)
+        {
+          if (isSpaceWaiter == false)
+          {
+            //Pools notify free channels only while someone waits, so register before the next try.
+            for (auto index : poolIndexVec)
+            {
+              shmPoolVec_[index]->addSpaceWaiter();
+            }
+            isSpaceWaiter = true;
+          }
+          //Free sequences are loaded before trying pools, so blocks freed meanwhile wake the park below.
+          channelVec.clear();
+          sequenceVec.clear();
+          for (auto index : poolIndexVec)
+          {
+            auto freeChannel_raw_ptr = shmPoolVec_[index]->getFreeChannel().get();
+            channelVec.emplace_back(freeChannel_raw_ptr);
+            sequenceVec.emplace_back(freeChannel_raw_ptr->getNotifySequence());
+          }
+        }
+
+        bool tooLarge = true;
+        for (auto index : poolIndexVec)
+        {
+          auto result = shmPoolVec_[index]->requireMsgShm(data_size, msgVec);
+          if (result == shmMsgPool::ALLOC_RESULT::SUCCESS)
+          {
+            poolIndex = index;
+            isAllocated = true;
+            break;
+          }
+          tooLarge = tooLarge && (result == shmMsgPool::ALLOC_RESULT::TOO_LARGE);
+        }
+        if (isAllocated)
         {
-          auto msg_vec = shmPool_ptr_->requireMsgShm(data_size);
-          return msg_vec;
+          break;
         }
-        catch (const std::exception& e)
+        if (tooLarge)
+        {
+          LOG_ERROR("message of {} bytes is larger than every pool of topic {}", data_size, identity_);
+          break;
+        }
+
+        LOG_DEBUG("message shm pool is too low for {} bytes", data_size);
+        if (i < retryTime)
         {
-          LOG_ERROR("message shm pool is too low");
           recycleExpireMsg();
+          continue;
+        }
+        if (waitSpace == false || std::chrono::steady_clock::now() >= deadline)
+        {
+          break;
+        }
+        if (recycleExpireMsg() == PROCESS_SUCCESS)
+        {
+          continue;
+        }
+        //Nothing is left to recycle, wait for readers to give borrowed blocks back.
+        if (shmChannel::parkWaitAny(channelVec.data(), sequenceVec.data(), static_cast<uint32_t>(channelVec.size()), &deadline) == PROCESS_FAIL)
+        {
+          break;
         }
       }
-      return std::vector<uint32_t>{};
+
+      if (isSpaceWaiter)
+      {
+        for (auto index : poolIndexVec)
+        {
+          shmPoolVec_[index]->removeSpaceWaiter();
+        }
+      }
+      if (isAllocated == false)
+      {
+        msgVec.clear();
+      }
+      return msgVec;
     }
 
-    bool recycleMsg(uint32_t msgIndex)
+    /// @brief Give back messages of a batch whose blocks aren't published, their sequence is SHM_INVALID_SEQUENCE.
+    void recycleMsgBatch(const std::vector<uint32_t> &msgIndexVec, const std::vector<shmIndexRingBuffer::ringBufferIndexBlockType> &blockVec)
     {
-      assert(msgIndex < SHM_BLOCK_NUM && "msg shm index is out of range");
-      for (;msgIndex != SHM_INVALID_INDEX;)
+      for (size_t i = 0; i < msgIndexVec.size(); i++)
       {
-        auto msgBlock = FIND_SHARE_MEM_BLOCK_ADDR(msgShm_raw_ptr_, msgIndex);
-        auto msgBlockIns = reinterpret_cast<msgType*>(msgBlock);
-        auto nextIndex = msgBlockIns->next_;
-        shmPool_ptr_->recycleMsgShm(msgIndex);
-        msgIndex = nextIndex;
+        if (blockVec[i].sequence_ == SHM_INVALID_SEQUENCE)
+        {
+          shmPoolVec_[blockVec[i].poolIndex_]->recycleMsgChain(msgIndexVec[i]);
+        }
       }
-      return PROCESS_SUCCESS;
     }
 
+    /// @brief Move start index and retire the oldest message.
+    ///        A message still borrowed by readers is recycled by its last reader instead.
+    ///        If a reliable reader hasn't consumed the oldest message, full policy decides what to do.
     bool recycleExpireMsg()
     {
+      if (waitSlowestReader() == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
+
       shmIndexRingBuffer::ringBufferIndexBlockType block;
       if (ringBuffer_ptr_->moveStartIndex(block) == PROCESS_FAIL)
       {
         return PROCESS_FAIL;
       }
 
-      return recycleMsg(block.shmMsgIndex_);
+      if (block.poolIndex_ >= shmPoolVec_.size())
+      {
+        LOG_ERROR("message {} is in unknown pool {}", block.shmMsgIndex_, block.poolIndex_);
+        return PROCESS_FAIL;
+      }
+      shmPoolVec_[block.poolIndex_]->retireMsgShm(block.shmMsgIndex_);
+      return PROCESS_SUCCESS;
     }
 
-    bool readBuffer(void *read_data, uint32_t &data_len, uint32_t msgHeadIndex, uint32_t msgSize)
+    /// @brief Retire messages beyond history depth or older than lifespan ahead of publishers.
+    ///        Unlike recycleExpireMsg it never waits, a message unread by a reliable reader stops it
+    ///        unless full policy is DROP_OLDEST.
+    /// @param maxNum most messages retired by one call.
+    /// @return number of retired messages.
+    uint32_t reclaimMsg(uint32_t maxNum)
     {
-      auto msgIndex = msgHeadIndex;
-      data_len = 0;
-      if (msgIndex == SHM_INVALID_INDEX || msgSize == 0)
+      uint32_t reclaimNum = 0;
+      auto now = getTimestamp();
+      while (reclaimNum < maxNum)
       {
-        return PROCESS_FAIL;
+        shmIndexRingBuffer::ringBufferIndexBlockType block;
+        uint64_t startIndex;
+        if (ringBuffer_ptr_->getStartIndex(startIndex, block) == PROCESS_FAIL)
+        {
+          break;
+        }
+        bool overDepth = historyDepth_ != 0 && ringBuffer_ptr_->getEndIndex() - startIndex > historyDepth_;
+        bool expired = lifespanNs_ != 0 && now > block.timeStamp_ && now - block.timeStamp_ > lifespanNs_;
+        if (!overDepth && !expired)
+        {
+          break;
+        }
+        if (fullPolicy_ != qosCfg::FULL_POLICY::DROP_OLDEST)
+        {
+          auto minCursor = ringBuffer_ptr_->getMinReaderCursor();
+          if (minCursor != SHM_INVALID_SEQUENCE && minCursor <= startIndex)
+          {
+            break;
+          }
+        }
+        //Publisher recycled it meanwhile, check the new oldest message.
+        if (ringBuffer_ptr_->moveStartIndex(startIndex, block) == PROCESS_FAIL)
+        {
+          continue;
+        }
+        if (block.poolIndex_ >= shmPoolVec_.size())
+        {
+          LOG_ERROR("message {} is in unknown pool {}", block.shmMsgIndex_, block.poolIndex_);
+          break;
+        }
+        shmPoolVec_[block.poolIndex_]->retireMsgShm(block.shmMsgIndex_);
+        reclaimNum++;
       }
+      return reclaimNum;
+    }
 
-      for (;msgIndex != SHM_INVALID_INDEX;)
+    /// @brief Apply full policy until oldest message is consumed by every registered reader.
+    /// @return PROCESS_FAIL if BLOCK policy times out.
+    bool waitSlowestReader()
+    {
+      if (fullPolicy_ == qosCfg::FULL_POLICY::DROP_OLDEST)
       {
-        auto msgBlock = FIND_SHARE_MEM_BLOCK_ADDR(msgShm_raw_ptr_, msgIndex);
-        auto msgBlockIns = reinterpret_cast<msgType*>(msgBlock);
-
-        if ((msgSize - data_len) < SHM_BLOCK_CONTENT_SIZE)
+        return PROCESS_SUCCESS;
+      }
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(fullTimeoutUs_);
+      for (uint32_t i = 0;; i++)
+      {
+        shmIndexRingBuffer::ringBufferIndexBlockType block;
+        uint64_t startIndex;
+        if (ringBuffer_ptr_->getStartIndex(startIndex, block) == PROCESS_FAIL)
         {
-          std::memcpy(((char*)read_data + data_len), msgBlockIns->content_, (msgSize - data_len));
-          data_len += (msgSize - data_len);
+          return PROCESS_SUCCESS;
+        }
+        auto minCursor = ringBuffer_ptr_->getMinReaderCursor();
+        if (minCursor == SHM_INVALID_SEQUENCE || minCursor > startIndex)
+        {
+          return PROCESS_SUCCESS;
+        }
+        //A busy reader can't be evicted, so eviction falls back to waiting for it like BLOCK.
+        if (fullPolicy_ == qosCfg::FULL_POLICY::EVICT_SLOWEST && ringBuffer_ptr_->evictSlowestReader() == PROCESS_SUCCESS)
+        {
+          continue;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+          LOG_WARN("slowest reader of topic {} stays at {}, give up recycling", identity_, minCursor);
+          return PROCESS_FAIL;
+        }
+        if (i < SHM_SPIN_RETRY_NUM)
+        {
+          cpuRelax();
         }
         else
         {
-          std::memcpy(((char*)read_data + data_len), msgBlockIns->content_, SHM_BLOCK_CONTENT_SIZE);
-          data_len += SHM_BLOCK_CONTENT_SIZE;
+          std::this_thread::yield();
         }
-        msgIndex = msgBlockIns->next_;
       }
+    }
+
+    bool readBuffer(void *read_data, uint32_t &data_len, shmIndexRingBuffer::ringBufferIndexBlockType &block)
+    {
+      auto msgSize = block.msgSize_;
+      data_len = 0;
+      if (block.shmMsgIndex_ == SHM_INVALID_INDEX || msgSize == 0 || block.poolIndex_ >= shmPoolVec_.size())
+      {
+        return PROCESS_FAIL;
+      }
+
+      data_len = walkMsgExtent(*shmPoolVec_[block.poolIndex_], block.shmMsgIndex_, msgSize, [&read_data](char *content, uint32_t contentLen) {
+        std::memcpy(read_data, content, contentLen);
+        read_data = (char*)read_data + contentLen;
+      });
 
       if (data_len == msgSize)
       {
@@ -338,14 +750,43 @@ namespace dawn
       return PROCESS_FAIL;
     }
 
+    /// @brief Walk extents of a message in order, content of every extent is contiguous.
+    /// @note Blocks may be recycled while walking without pin, so never trust the chain beyond message size.
+    /// @param shmPool pool holding message.
+    /// @param msgHeadIndex
+    /// @param msgSize
+    /// @param func called with content and length of every extent.
+    /// @return length of walked content, it is less than msgSize if chain is broken.
+    template<typename FUNC_T>
+    uint32_t walkMsgExtent(shmMsgPool &shmPool, uint32_t msgHeadIndex, uint32_t msgSize, FUNC_T &&func)
+    {
+      uint32_t walkLen = 0;
+      auto poolBlockNum = shmPool.getBlockNum();
+      for (auto msgIndex = msgHeadIndex; msgIndex < poolBlockNum && walkLen < msgSize;)
+      {
+        auto msgBlockIns = shmPool.getMsgBlock(msgIndex);
+        auto blockNum = std::min(std::max(msgBlockIns->blockNum_, 1U), poolBlockNum - msgIndex);
+        auto contentLen = std::min(msgSize - walkLen, shmPool.getExtentContentSize(blockNum));
+        func(msgBlockIns->content_, contentLen);
+        walkLen += contentLen;
+        msgIndex = msgBlockIns->next_;
+      }
+      return walkLen;
+    }
+
     protected:
     std::string           identity_;
-    void                  *msgShm_raw_ptr_;
-    std::atomic<uint32_t>         lockMsgOwns_;
-    std::shared_mutex             lockMsgMutex_;
     std::shared_ptr<shmChannel>            channel_ptr_;
-    std::shared_ptr<shmMsgPool>            shmPool_ptr_;
+    /// @brief Pools of topic sorted by block size.
+    std::vector<std::shared_ptr<shmMsgPool>>  shmPoolVec_;
     std::shared_ptr<shmIndexRingBuffer>    ringBuffer_ptr_;
+    qosCfg::FULL_POLICY                    fullPolicy_;
+    uint32_t                               fullTimeoutUs_;
+    uint32_t                               allocTimeoutUs_;
+    uint64_t                               lifespanNs_;
+    uint32_t                               historyDepth_;
+    /// @brief Held only if lifespan or history depth is set.
+    std::shared_ptr<shmReclaimer>          reclaimer_ptr_;
   };
 }
 
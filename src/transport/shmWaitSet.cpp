@@ -0,0 +1,113 @@
+#include "shmWaitSet.h"
+#include "common/setLogger.h"
+
+namespace dawn
+{
+  uint32_t shmWaitSet::attach(std::shared_ptr<shmTransport> transport_ptr)
+  {
+    if (!transport_ptr)
+    {
+      return SHM_INVALID_INDEX;
+    }
+    uint32_t index = 0;
+    for (; index < entryVec_.size() && entryVec_[index].transport_ptr_; index++);
+    if (index >= SHM_WAIT_CHANNEL_MAX_NUM)
+    {
+      LOG_ERROR("wait set is full, it holds {} topics", entryNum_);
+      return SHM_INVALID_INDEX;
+    }
+    if (index == entryVec_.size())
+    {
+      entryVec_.emplace_back();
+    }
+
+    auto &entry = entryVec_[index];
+    entry.channel_ptr_ = transport_ptr->getChannel();
+    entry.transport_ptr_ = std::move(transport_ptr);
+    //Differ from current sequence, so the first wait reports topic.
+    entry.seenSequence_ = entry.channel_ptr_->getNotifySequence() - 1;
+    entryNum_++;
+    return index;
+  }
+
+  bool shmWaitSet::detach(uint32_t index)
+  {
+    if (index >= entryVec_.size() || !entryVec_[index].transport_ptr_)
+    {
+      return PROCESS_FAIL;
+    }
+    entryVec_[index] = entryType();
+    entryNum_--;
+    while (!entryVec_.empty() && !entryVec_.back().transport_ptr_)
+    {
+      entryVec_.pop_back();
+    }
+    return PROCESS_SUCCESS;
+  }
+
+  std::shared_ptr<shmTransport> shmWaitSet::getTransport(uint32_t index) const
+  {
+    if (index >= entryVec_.size())
+    {
+      return nullptr;
+    }
+    return entryVec_[index].transport_ptr_;
+  }
+
+  uint32_t shmWaitSet::size() const
+  {
+    return entryNum_;
+  }
+
+  bool shmWaitSet::wait(std::vector<uint32_t> &readyVec)
+  {
+    return waitUntil(readyVec, nullptr);
+  }
+
+  bool shmWaitSet::waitFor(std::vector<uint32_t> &readyVec, uint32_t microseconds)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(microseconds);
+    return waitUntil(readyVec, &deadline);
+  }
+
+  bool shmWaitSet::waitUntil(std::vector<uint32_t> &readyVec, const std::chrono::steady_clock::time_point *deadline)
+  {
+    readyVec.clear();
+    if (entryNum_ == 0)
+    {
+      return PROCESS_FAIL;
+    }
+
+    for (;;)
+    {
+      channelVec_.clear();
+      sequenceVec_.clear();
+      for (uint32_t index = 0; index < entryVec_.size(); index++)
+      {
+        auto &entry = entryVec_[index];
+        if (!entry.transport_ptr_)
+        {
+          continue;
+        }
+        ///@note Sequence is recorded before caller drains topic, so a publish during draining is reported next time.
+        auto sequence = entry.channel_ptr_->getNotifySequence();
+        if (sequence != entry.seenSequence_)
+        {
+          entry.seenSequence_ = sequence;
+          readyVec.push_back(index);
+        }
+        channelVec_.push_back(entry.channel_ptr_.get());
+        sequenceVec_.push_back(sequence);
+      }
+      if (!readyVec.empty())
+      {
+        return PROCESS_SUCCESS;
+      }
+      if (shmChannel::parkWaitAny(channelVec_.data(), sequenceVec_.data(), static_cast<uint32_t>(channelVec_.size()), \
+        deadline) == PROCESS_FAIL)
+      {
+        return PROCESS_FAIL;
+      }
+    }
+  }
+}
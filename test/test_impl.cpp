@@ -3,10 +3,13 @@
 #include <chrono>
 #include <cstdlib>
 #include <future>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "test_helper.h"
 
 #include "common/memoryPool.h"
+#include "common/memoryPolicy.h"
 #include "common/multicast.h"
 #include "discovery/discovery.h"
 #include "transport/shmTransport.h"
@@ -105,6 +108,163 @@ TEST(test_dawn, test_shm_pool)
   std::cout << std::endl;
 }
 
+TEST(test_dawn, test_shm_pool_extent)
+{
+  using namespace dawn;
+  shmMsgPool test_pool("dawn_test_pool");
+  auto freeBlockNum = test_pool.getFreeBlockNum();
+
+  auto func = [&](uint32_t seed) {
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+      uint32_t dataSize = (seed * 7919 + i * 104729) % (SHM_BLOCK_CONTENT_SIZE * 100) + 1;
+      std::vector<uint32_t> indexVec;
+      ASSERT_EQ(test_pool.requireMsgShm(dataSize, indexVec), shmMsgPool::ALLOC_RESULT::SUCCESS);
+      ASSERT_FALSE(indexVec.empty());
+      uint32_t contentSize = 0;
+      for (size_t j = 0; j < indexVec.size(); j++)
+      {
+        auto msgIns = test_pool.getMsgBlock(indexVec[j]);
+        ASSERT_EQ(msgIns->next_, (j + 1 < indexVec.size()) ? indexVec[j + 1] : SHM_INVALID_INDEX);
+        contentSize += test_pool.getExtentContentSize(msgIns->blockNum_);
+        std::memset(msgIns->content_, seed, test_pool.getExtentContentSize(msgIns->blockNum_));
+      }
+      ASSERT_GE(contentSize, dataSize);
+      test_pool.recycleMsgChain(indexVec.front());
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    threads.emplace_back(func, i);
+  }
+  for (auto &it : threads)
+  {
+    it.join();
+  }
+  EXPECT_EQ(test_pool.getFreeBlockNum(), freeBlockNum);
+
+  //Fragment pool by holding every other block, then a big message falls back to a chain.
+  std::vector<uint32_t> holdVec;
+  for (auto index = test_pool.requireOneBlock(); index != SHM_INVALID_INDEX; index = test_pool.requireOneBlock())
+  {
+    holdVec.emplace_back(index);
+  }
+  for (size_t i = 0; i < holdVec.size(); i += 2)
+  {
+    test_pool.recycleMsgShm(holdVec[i]);
+  }
+  std::vector<uint32_t> indexVec;
+  ASSERT_EQ(test_pool.requireMsgShm(SHM_BLOCK_CONTENT_SIZE * 8, indexVec), shmMsgPool::ALLOC_RESULT::SUCCESS);
+  EXPECT_GT(indexVec.size(), 1);
+  test_pool.recycleMsgChain(indexVec.front());
+  for (size_t i = 1; i < holdVec.size(); i += 2)
+  {
+    test_pool.recycleMsgShm(holdVec[i]);
+  }
+  EXPECT_EQ(test_pool.getFreeBlockNum(), freeBlockNum);
+
+  ASSERT_EQ(test_pool.requireMsgShm(SHM_BLOCK_CONTENT_SIZE * 100, indexVec), shmMsgPool::ALLOC_RESULT::SUCCESS);
+  EXPECT_EQ(indexVec.size(), 1);
+  test_pool.recycleMsgChain(indexVec.front());
+}
+
+TEST(test_dawn, test_shm_pool_version)
+{
+  using namespace dawn;
+  namespace BI = boost::interprocess;
+  BI::shared_memory_object::remove("dawn_test_pool_version");
+  BI::shared_memory_object::remove("msm.dawn_test_pool_version");
+  {
+    shmMsgPool pool("dawn_test_pool_version", SHM_SIZE_CLASS_64B, 64);
+    EXPECT_NO_THROW(shmMsgPool("dawn_test_pool_version", SHM_SIZE_CLASS_64B, 64));
+  }
+
+  //A pool left by a build with another layout is refused.
+  BI::shared_memory_object stalePool(BI::open_only, "dawn_test_pool_version", BI::read_write);
+  BI::mapped_region staleRegion(stalePool, BI::read_write);
+  reinterpret_cast<shmMsgPool::poolHeadType*>(staleRegion.get_address())->version_ = SHM_POOL_SEGMENT_VERSION + 1;
+  EXPECT_THROW(shmMsgPool("dawn_test_pool_version", SHM_SIZE_CLASS_64B, 64), std::runtime_error);
+  BI::shared_memory_object::remove("dawn_test_pool_version");
+  BI::shared_memory_object::remove("msm.dawn_test_pool_version");
+}
+
+TEST(test_dawn, test_shm_pool_create)
+{
+  using namespace dawn;
+  //Block number is not a multiple of bitmap word, blocks past the last one must never be claimed.
+  shmMsgPool test_pool("dawn_test_pool_create", SHM_SIZE_CLASS_64B, 100);
+  ASSERT_EQ(test_pool.getFreeBlockNum(), 100);
+
+  std::vector<uint32_t> holdVec;
+  for (auto index = test_pool.requireOneBlock(); index != SHM_INVALID_INDEX; index = test_pool.requireOneBlock())
+  {
+    ASSERT_LT(index, 100);
+    holdVec.emplace_back(index);
+  }
+  EXPECT_EQ(holdVec.size(), 100);
+  EXPECT_EQ(test_pool.getFreeBlockNum(), 0);
+  for (auto index : holdVec)
+  {
+    test_pool.recycleMsgShm(index);
+  }
+  EXPECT_EQ(test_pool.getFreeBlockNum(), 100);
+
+  std::vector<uint32_t> indexVec;
+  ASSERT_EQ(test_pool.requireMsgShm(SHM_SIZE_CLASS_64B * 100, indexVec), shmMsgPool::ALLOC_RESULT::SUCCESS);
+  EXPECT_EQ(indexVec.size(), 1);
+  auto heldIndex = indexVec.front();
+
+  //Short pool and oversized data are reported by status, nothing is thrown.
+  auto freeBlockNum = test_pool.getFreeBlockNum();
+  EXPECT_EQ(test_pool.requireMsgShm(SHM_SIZE_CLASS_64B * 20, indexVec), shmMsgPool::ALLOC_RESULT::NO_SPACE);
+  EXPECT_TRUE(indexVec.empty());
+  EXPECT_EQ(test_pool.getFreeBlockNum(), freeBlockNum);
+  EXPECT_EQ(test_pool.requireMsgShm(SHM_SIZE_CLASS_64B * 120, indexVec), shmMsgPool::ALLOC_RESULT::TOO_LARGE);
+  //Without space waiters a release leaves free channel alone, a registered waiter gets notified.
+  auto freeSequence = test_pool.getFreeChannel()->getNotifySequence();
+  test_pool.recycleMsgChain(heldIndex);
+  EXPECT_EQ(test_pool.getFreeChannel()->getNotifySequence(), freeSequence);
+  ASSERT_EQ(test_pool.requireMsgShm(SHM_SIZE_CLASS_64B * 100, indexVec), shmMsgPool::ALLOC_RESULT::SUCCESS);
+  test_pool.addSpaceWaiter();
+  test_pool.recycleMsgChain(indexVec.front());
+  EXPECT_NE(test_pool.getFreeChannel()->getNotifySequence(), freeSequence);
+  test_pool.removeSpaceWaiter();
+}
+
+TEST(test_dawn, test_memory_policy)
+{
+  using namespace dawn;
+  auto defaultPolicy = getMemoryPolicy();
+  memoryPolicy policy;
+  policy.hugePage_ = true;
+  policy.prefault_ = true;
+  policy.lock_ = true;
+  setMemoryPolicy(policy);
+
+  //Hugepage slab is rounded to hugepage size, fallback slab keeps requested size.
+  size_t len = 3 * 1024 * 1024 + 1;
+  auto slab = reinterpret_cast<char*>(allocRegion(len));
+  ASSERT_NE(slab, nullptr);
+  EXPECT_GE(len, 3 * 1024 * 1024 + 1);
+  EXPECT_TRUE(len == 3 * 1024 * 1024 + 1 || len % HUGE_PAGE_SIZE == 0);
+  EXPECT_EQ(slab[0], 0);
+  EXPECT_EQ(slab[len - 1], 0);
+  slab[len - 1] = 1;
+  freeRegion(slab, len);
+
+  //Failing to lock or advise is only logged, so topic still works.
+  shmTransport tp("dawn_test_memory_policy", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+  std::string msg("memory policy");
+  ASSERT_EQ(tp.write(msg.c_str(), msg.size()), PROCESS_SUCCESS);
+  std::vector<char> data(msg.size());
+  uint32_t data_len = 0;
+  ASSERT_EQ(tp.read(data.data(), data_len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(std::string(data.data(), data_len), msg);
+  setMemoryPolicy(defaultPolicy);
+}
+
 TEST(test_dawn, test_shmChannel_notify)
 {
   using namespace dawn;
@@ -149,4 +309,183 @@ TEST(test_dawn, test_shmChannel_try_wait)
   }
 }
 
+TEST(test_dawn, test_shmChannel_futex)
+{
+  using namespace dawn;
+  shmChannel a("dawn_test_channel_futex");
+  //Nobody waits, notification only bumps futex word.
+  a.notifyAll();
+  EXPECT_FALSE(a.tryWaitNotify(1000U));
+
+  std::atomic<uint32_t> cursor{0};
+  std::atomic<uint32_t> wakeNum{0};
+  auto func = [&](uint32_t target) {
+    a.waitNotify([&]() {
+      return cursor.load() >= target;
+    });
+    wakeNum++;
+  };
+  std::thread first(func, 1);
+  std::thread second(func, 3);
+  for (uint32_t i = 1; i <= 3; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    cursor = i;
+    a.notifyAll();
+    if (i == 1)
+    {
+      first.join();
+      EXPECT_EQ(wakeNum.load(), 1);
+    }
+  }
+  second.join();
+  EXPECT_EQ(wakeNum.load(), 2);
+  EXPECT_TRUE(a.tryWaitNotify([&]() { return cursor.load() == 3; }, 10));
+}
+
+
+TEST(test_dawn, test_shmIndexRingBuffer_sequence)
+{
+  using namespace dawn;
+  shmIndexRingBuffer ring("dawn_test_ring");
+  shmIndexRingBuffer::ringBufferIndexBlockType block{};
+  uint64_t firstIndex = SHM_INVALID_SEQUENCE;
+  uint64_t storePosition = SHM_INVALID_SEQUENCE;
+  for (uint32_t i = 0; i < 16; i++)
+  {
+    block.shmMsgIndex_ = i;
+    block.msgSize_ = i + 1;
+    ASSERT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+    if (firstIndex == SHM_INVALID_SEQUENCE)
+    {
+      firstIndex = storePosition;
+    }
+  }
+
+  uint64_t latestIndex;
+  ASSERT_EQ(ring.getLatestBuffer(block, latestIndex), PROCESS_SUCCESS);
+  EXPECT_EQ(latestIndex, storePosition);
+  EXPECT_EQ(block.shmMsgIndex_, 15);
+
+  ASSERT_EQ(ring.getSpecificIndexBuffer(firstIndex + 3, block), PROCESS_SUCCESS);
+  EXPECT_EQ(block.msgSize_, 4);
+  EXPECT_FALSE(ring.checkIndexValid(storePosition + 1));
 
+  //Sequence is the ring index, timestamp is nanosecond publish time.
+  uint64_t lastTimeStamp = 0;
+  for (auto index = firstIndex; index <= storePosition; index++)
+  {
+    ASSERT_EQ(ring.getSpecificIndexBuffer(index, block), PROCESS_SUCCESS);
+    EXPECT_EQ(block.sequence_, index);
+    EXPECT_GE(block.timeStamp_, lastTimeStamp);
+    lastTimeStamp = block.timeStamp_;
+  }
+  EXPECT_GT(lastTimeStamp, 0);
+  EXPECT_EQ(sizeof(shmIndexRingBuffer::ringBufferIndexBlockType), SHM_INDEX_BLOCK_SIZE);
+}
+
+TEST(test_dawn, test_shmIndexRingBuffer_stalled_publisher)
+{
+  using namespace dawn;
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_stall");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_stall").c_str());
+  shmIndexRingBuffer ring("dawn_test_ring_stall", 16);
+  shmIndexRingBuffer::ringBufferIndexBlockType block{};
+  uint64_t storePosition;
+  block.shmMsgIndex_ = 1;
+  ASSERT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+  //A publisher claims the next sequence and dies before filling its slot.
+  auto stalledIndex = ring.ringBuffer_raw_ptr_->claimIndex_.fetch_add(1);
+
+  block.shmMsgIndex_ = 2;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::microseconds(SHM_RING_COMMIT_TIMEOUT_US));
+  EXPECT_EQ(storePosition, stalledIndex + 1);
+  EXPECT_EQ(ring.getEndIndex(), stalledIndex + 2);
+  EXPECT_EQ(ring.getSpecificIndexBuffer(stalledIndex, block), PROCESS_FAIL);
+
+  //Readers and recycling step over the abandoned slot.
+  ASSERT_EQ(ring.moveStartIndex(block), PROCESS_SUCCESS);
+  EXPECT_EQ(block.shmMsgIndex_, 1);
+  ASSERT_EQ(ring.moveStartIndex(block), PROCESS_SUCCESS);
+  EXPECT_EQ(block.shmMsgIndex_, 2);
+  EXPECT_EQ(ring.moveStartIndex(block), PROCESS_FAIL);
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_stall");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_stall").c_str());
+}
+
+TEST(test_dawn, test_shmIndexRingBuffer_dead_reader)
+{
+  using namespace dawn;
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_dead_reader");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_dead_reader").c_str());
+  shmIndexRingBuffer ring("dawn_test_ring_dead_reader", 16);
+  shmIndexRingBuffer::ringBufferIndexBlockType block{};
+  uint64_t storePosition;
+  ASSERT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+  auto childPid = fork();
+  if (childPid == 0)
+  {
+    _exit(0);
+  }
+  ASSERT_GT(childPid, 0);
+  waitpid(childPid, nullptr, 0);
+
+  //A reader dies while registering, after its pid is stored.
+  auto &reader = ring.ringBuffer_raw_ptr_->readerCursor_[0];
+  reader.pid_ = static_cast<uint32_t>(childPid);
+  reader.state_ = shmIndexRingBuffer::READER_BUSY;
+  ring.ringBuffer_raw_ptr_->readerSlotNum_ = 1;
+  EXPECT_EQ(ring.getMinReaderCursor(), SHM_INVALID_SEQUENCE);
+  EXPECT_EQ(reader.state_, shmIndexRingBuffer::READER_FREE);
+  EXPECT_EQ(reader.pid_, 0);
+
+  //A reader dies before its pid is stored, its slot holds start index but can't be evicted.
+  reader.state_ = shmIndexRingBuffer::READER_BUSY;
+  EXPECT_EQ(ring.getMinReaderCursor(), 0);
+  EXPECT_EQ(ring.evictSlowestReader(), PROCESS_FAIL);
+  EXPECT_EQ(reader.state_, shmIndexRingBuffer::READER_BUSY);
+
+  //Active reader ahead of start index isn't evicted for a busy one.
+  auto readerId = ring.registerReader();
+  ASSERT_EQ(readerId, 1);
+  ring.updateReaderCursor(readerId, 1);
+  EXPECT_EQ(ring.evictSlowestReader(), PROCESS_FAIL);
+  EXPECT_EQ(ring.ringBuffer_raw_ptr_->readerCursor_[readerId].state_, shmIndexRingBuffer::READER_ACTIVE);
+  reader.state_ = shmIndexRingBuffer::READER_FREE;
+  ring.unregisterReader(readerId);
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_dead_reader");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_dead_reader").c_str());
+}
+
+TEST(test_dawn, test_shmIndexRingBuffer_depth)
+{
+  using namespace dawn;
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_depth");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_depth").c_str());
+  EXPECT_THROW(shmIndexRingBuffer("dawn_test_ring_depth", 100), std::runtime_error);
+
+  shmIndexRingBuffer ring("dawn_test_ring_depth", 16);
+  shmIndexRingBuffer attachRing("dawn_test_ring_depth");
+  ASSERT_EQ(ring.getRingDepth(), 16);
+  ASSERT_EQ(attachRing.getRingDepth(), 16);
+
+  shmIndexRingBuffer::ringBufferIndexBlockType block{};
+  uint64_t storePosition;
+  for (uint32_t i = 0; i < 40; i++)
+  {
+    block.shmMsgIndex_ = i;
+    ASSERT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+    ASSERT_EQ(attachRing.moveStartIndex(block), PROCESS_SUCCESS);
+    EXPECT_EQ(block.shmMsgIndex_, i);
+  }
+
+  for (uint32_t i = 0; i < 16; i++)
+  {
+    ASSERT_EQ(attachRing.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::SUCCESS);
+  }
+  EXPECT_EQ(ring.moveEndIndex(block, storePosition), shmIndexRingBuffer::PROCESS_RESULT::BUFFER_FILL);
+  boost::interprocess::shared_memory_object::remove("dawn_test_ring_depth");
+  boost::interprocess::shared_memory_object::remove((std::string(MECHANISM_PREFIX) + "dawn_test_ring_depth").c_str());
+}
@@ -1,10 +1,18 @@
 #include "gtest/gtest.h"
 #include <string>
 #include <array>
+#include <map>
+#include <set>
 #include <thread>
 #include <chrono>
 #include <future>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "transport/shmTransportController.h"
+#include "transport/shmTopic.h"
+#include "transport/shmListener.h"
+#include "transport/shmWaitSet.h"
+#include <sys/epoll.h>
 #include "common/setLogger.h"
 
 
@@ -463,3 +471,855 @@ TEST(test_dawn, test_shmTp_write_read_loopback)
   }
 }
 
+
+TEST(test_dawn, shmTpLoanPublish)
+{
+  using namespace dawn;
+  shmTransport tp("dawn_loan", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+  shmLoanedMsg loanedMsg;
+  uint32_t msgLen = 3 * 1024 + 7;
+  ASSERT_EQ(tp.loan(msgLen, loanedMsg), PROCESS_SUCCESS);
+  ASSERT_EQ(loanedMsg.size(), msgLen);
+  uint32_t written = 0;
+  for (auto &fragment : loanedMsg.fragments())
+  {
+    for (uint32_t i = 0; i < fragment.iov_len; i++)
+    {
+      static_cast<char*>(fragment.iov_base)[i] = static_cast<char>((written + i) & 0x7f);
+    }
+    written += fragment.iov_len;
+  }
+  ASSERT_EQ(written, msgLen);
+  ASSERT_EQ(tp.publish(loanedMsg), PROCESS_SUCCESS);
+  EXPECT_FALSE(loanedMsg.valid());
+
+  std::vector<char> data(9 * 1024);
+  uint32_t len = 0;
+  ASSERT_EQ(tp.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  ASSERT_EQ(len, msgLen);
+  for (uint32_t i = 0; i < len; i++)
+  {
+    ASSERT_EQ(data[i], static_cast<char>(i & 0x7f));
+  }
+}
+
+TEST(test_dawn, shmTpBorrowSurviveRecycle)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_borrow");
+  //Topic floods its ring, so it owns a pool instead of draining the global pool shared by other tests.
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::EFFICIENT);
+  cfg->ringDepth_ = 16;
+  cfg->shmPoolCfgVec_ = {{SHM_SIZE_CLASS_256B, 64}};
+  shmTransport tp("dawn_borrow", cfg);
+  std::string data(2 * 1024 + 5, 'b');
+  ASSERT_EQ(tp.write(data.c_str(), data.size()), PROCESS_SUCCESS);
+
+  shmBorrowedMsg borrowedMsg;
+  ASSERT_EQ(tp.borrow(borrowedMsg, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  ASSERT_EQ(borrowedMsg.size(), data.size());
+
+  //Flood ring buffer, so the borrowed message is expired.
+  std::string other(64, 'x');
+  for (uint32_t i = 0; i < cfg->ringDepth_ * 2; i++)
+  {
+    ASSERT_EQ(tp.write(other.c_str(), other.size()), PROCESS_SUCCESS);
+  }
+
+  std::string borrowed;
+  for (auto &fragment : borrowedMsg.fragments())
+  {
+    borrowed.append(static_cast<const char*>(fragment.iov_base), fragment.iov_len);
+  }
+  EXPECT_EQ(borrowed, data);
+  borrowedMsg.release();
+  EXPECT_FALSE(borrowedMsg.valid());
+  shmTopicSegment::remove("dawn_borrow");
+}
+
+TEST(test_dawn, shmTpSizeClassPool)
+{
+  using namespace dawn;
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  cfg->shmPoolCfgVec_ = {{SHM_SIZE_CLASS_16K, 16}, {SHM_SIZE_CLASS_64B, 256}, {SHM_SIZE_CLASS_1K, 64}};
+  shmTransport tp("dawn_size_class", cfg);
+  shmTopicSegment segment("dawn_size_class");
+  ASSERT_EQ(segment.getPoolVec().size(), 3);
+  auto &smallPool = *segment.getPoolVec()[0];
+  auto &bigPool = *segment.getPoolVec()[2];
+  auto smallFreeBlockNum = smallPool.getFreeBlockNum();
+  auto bigFreeBlockNum = bigPool.getFreeBlockNum();
+
+  std::vector<char> data(9 * 1024);
+  uint32_t len = 0;
+  for (uint32_t msgLen : {32U, 900U, 40U * 1024U})
+  {
+    std::string msg(msgLen, static_cast<char>('a' + msgLen % 26));
+    ASSERT_EQ(tp.write(msg.c_str(), msg.size()), PROCESS_SUCCESS);
+    data.resize(msgLen);
+    ASSERT_EQ(tp.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    ASSERT_EQ(std::string(data.data(), len), msg);
+  }
+  EXPECT_EQ(smallPool.getFreeBlockNum(), smallFreeBlockNum - 1);
+  EXPECT_EQ(bigPool.getFreeBlockNum(), bigFreeBlockNum - 3);
+
+  //Attacher adopts geometry written by the creator.
+  auto attachCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  attachCfg->shmPoolCfgVec_ = {{SHM_SIZE_CLASS_64B, 512}};
+  attachCfg->ringDepth_ = 64;
+  shmTopicSegment attachSegment("dawn_size_class", *attachCfg);
+  ASSERT_EQ(attachSegment.getPoolVec().size(), 3);
+  EXPECT_EQ(attachSegment.getPoolVec()[0]->getBlockNum(), 256);
+  EXPECT_EQ(attachSegment.getRingBuffer()->getRingDepth(), SHM_RING_BUFFER_DEPTH);
+}
+
+TEST(test_dawn, shmTpTopicSegment)
+{
+  using namespace dawn;
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  cfg->ringDepth_ = 256;
+  cfg->shmPoolCfgVec_ = {{SHM_SIZE_CLASS_256B, 64}};
+  shmTransport writer("dawn_topic_segment", cfg);
+  shmTransport reader("dawn_topic_segment", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+
+  //Channel, ring buffer and pool of topic live in one share memory object.
+  EXPECT_TRUE(access("/dev/shm/topic.dawn_topic_segment", F_OK) == 0);
+  EXPECT_FALSE(access("/dev/shm/ring.dawn_topic_segment", F_OK) == 0);
+  EXPECT_FALSE(access("/dev/shm/ch.dawn_topic_segment", F_OK) == 0);
+
+  std::string msg("topic segment");
+  ASSERT_EQ(writer.write(msg.c_str(), msg.size()), PROCESS_SUCCESS);
+  std::vector<char> data(msg.size());
+  uint32_t len = 0;
+  ASSERT_EQ(reader.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(std::string(data.data(), len), msg);
+
+  //Default topics share one mapping of the global pool.
+  EXPECT_EQ(shmMsgPool::getGlobalPool(), shmMsgPool::getGlobalPool());
+}
+
+TEST(test_dawn, shmTpTopicRemove)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_topic_remove");
+  auto globalPool_ptr = shmMsgPool::getGlobalPool();
+  auto freeBlockNum = globalPool_ptr->getFreeBlockNum();
+  {
+    shmTransport tp("dawn_topic_remove", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::EFFICIENT));
+    std::string msg(1024, 'r');
+    for (int i = 0; i < 8; i++)
+    {
+      ASSERT_EQ(tp.write(msg.c_str(), msg.size()), PROCESS_SUCCESS);
+    }
+  }
+  EXPECT_LT(globalPool_ptr->getFreeBlockNum(), freeBlockNum);
+
+  //Removing topic gives messages held in the global pool back.
+  EXPECT_EQ(shmTopicSegment::remove("dawn_topic_remove"), PROCESS_SUCCESS);
+  EXPECT_EQ(globalPool_ptr->getFreeBlockNum(), freeBlockNum);
+  EXPECT_EQ(shmTopicSegment::remove("dawn_topic_remove"), PROCESS_FAIL);
+}
+
+TEST(test_dawn, shmTpTypedTopic)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_typed_topic");
+  shmTopicSegment::remove("dawn_typed_topic_big");
+  struct pose
+  {
+    double    x_;
+    double    y_;
+    uint64_t  sequence_;
+  };
+  struct bigPose
+  {
+    pose      poses_[16 * 1024];
+  };
+  static_assert(shmTopicTraits<pose>::SINGLE_BLOCK && shmTopicTraits<pose>::SIZE_CLASS == SHM_SIZE_CLASS_64B);
+  static_assert(shmTopicTraits<bigPose>::SINGLE_BLOCK == false);
+
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  shmSubscriber<pose> subscriber("dawn_typed_topic", cfg);
+  shmPublisher<pose> publisher("dawn_typed_topic", cfg);
+  for (uint64_t i = 0; i < 100; i++)
+  {
+    ASSERT_EQ(publisher.publish(1.0 * i, 2.0 * i, i), PROCESS_SUCCESS);
+    ASSERT_EQ(subscriber.take(abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    auto &msg = subscriber.get();
+    EXPECT_EQ(msg.sequence_, i);
+    EXPECT_EQ(msg.y_, 2.0 * i);
+  }
+  EXPECT_EQ(subscriber.take(abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_FAIL);
+  //Typed topic owns a pool of its size class.
+  shmTopicSegment segment("dawn_typed_topic");
+  ASSERT_EQ(segment.getPoolVec().size(), 1);
+  EXPECT_EQ(segment.getPoolVec()[0]->getBlockContentSize(), SHM_SIZE_CLASS_64B);
+
+  auto big_ptr = std::make_unique<bigPose>();
+  big_ptr->poses_[16 * 1024 - 1].sequence_ = 7;
+  shmSubscriber<bigPose> bigSubscriber("dawn_typed_topic_big", cfg);
+  shmPublisher<bigPose> bigPublisher("dawn_typed_topic_big", cfg);
+  ASSERT_EQ(bigPublisher.publish(*big_ptr), PROCESS_SUCCESS);
+  ASSERT_EQ(bigSubscriber.take(abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(bigSubscriber.get().poses_[16 * 1024 - 1].sequence_, 7);
+  shmTopicSegment::remove("dawn_typed_topic");
+  shmTopicSegment::remove("dawn_typed_topic_big");
+}
+
+TEST(test_dawn, shmTpSpinRead)
+{
+  using namespace dawn;
+  for (auto blockType : {abstractTransport::BLOCKING_TYPE::BUSY_POLL, abstractTransport::BLOCKING_TYPE::ADAPTIVE})
+  {
+    auto readerCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+    readerCfg->blockType_ = blockType;
+    readerCfg->spinBudgetUs_ = 10;
+    auto topic = "dawn_spin_read" + std::to_string(static_cast<int>(blockType));
+    shmTransport reader(topic, readerCfg);
+    shmTransport writer(topic, std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+    const uint32_t msgNum = 1000;
+
+    auto result = std::async(std::launch::async, [&]() {
+      uint32_t data = 0;
+      uint32_t len = 0;
+      for (uint32_t i = 0; i < msgNum; i++)
+      {
+        if (reader.read(&data, len) == PROCESS_FAIL || data != i)
+        {
+          return false;
+        }
+      }
+      return true;
+    });
+
+    for (uint32_t i = 0; i < msgNum; i++)
+    {
+      ASSERT_EQ(writer.write(&i, sizeof(i)), PROCESS_SUCCESS);
+      if (i % 100 == 0)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_TRUE(result.get());
+  }
+}
+
+TEST(test_dawn, shmTpWriteBatch)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_write_batch");
+  shmTransport tp("dawn_write_batch", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+  const uint32_t msgNum = 64;
+  std::vector<std::string> msgVec;
+  std::vector<iovec> iovVec;
+  for (uint32_t i = 0; i < msgNum; i++)
+  {
+    msgVec.emplace_back(1 + (i * 397) % 3000, static_cast<char>('a' + i % 26));
+  }
+  for (auto &msg : msgVec)
+  {
+    iovVec.emplace_back(iovec{msg.data(), msg.size()});
+  }
+  ASSERT_EQ(tp.writeBatch(iovVec.data(), msgNum), PROCESS_SUCCESS);
+  EXPECT_EQ(tp.writeBatch(iovVec.data(), 0), PROCESS_FAIL);
+
+  std::vector<char> data(4096);
+  for (uint32_t i = 0; i < msgNum; i++)
+  {
+    uint32_t len = 0;
+    ASSERT_EQ(tp.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    ASSERT_EQ(std::string(data.data(), len), msgVec[i]);
+  }
+  uint32_t len = 0;
+  EXPECT_EQ(tp.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_FAIL);
+  shmTopicSegment::remove("dawn_write_batch");
+}
+
+TEST(test_dawn, shmTpReadBatch)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_read_batch");
+  shmTransport tp("dawn_read_batch", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+  const uint32_t msgNum = 100;
+  for (uint32_t i = 0; i < msgNum; i++)
+  {
+    ASSERT_EQ(tp.write(&i, sizeof(i)), PROCESS_SUCCESS);
+  }
+
+  std::vector<uint32_t> readVec;
+  auto callback = [&readVec](const void *data, uint32_t data_len) {
+    ASSERT_EQ(data_len, sizeof(uint32_t));
+    readVec.emplace_back(*static_cast<const uint32_t*>(data));
+  };
+  uint32_t readCount = 0;
+  ASSERT_EQ(tp.readBatch(callback, 30, readCount, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(readCount, 30);
+
+  uint32_t data = 0;
+  uint32_t len = 0;
+  ASSERT_EQ(tp.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  readVec.emplace_back(data);
+
+  ASSERT_EQ(tp.readBatch(callback, 1000, readCount, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(readCount, msgNum - 31);
+  EXPECT_EQ(tp.readBatch(callback, 1000, readCount, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_FAIL);
+  EXPECT_EQ(readCount, 0);
+
+  ASSERT_EQ(readVec.size(), msgNum);
+  for (uint32_t i = 0; i < msgNum; i++)
+  {
+    EXPECT_EQ(readVec[i], i);
+  }
+  shmTopicSegment::remove("dawn_read_batch");
+}
+
+TEST(test_dawn, shmTpGatherWrite)
+{
+  using namespace dawn;
+  shmTransport tp("dawn_gather_write", std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE));
+  std::string header(16, 'h');
+  std::string payload(3000, 'p');
+  std::array<iovec, 3> iov{iovec{header.data(), header.size()}, iovec{nullptr, 0}, iovec{payload.data(), payload.size()}};
+  ASSERT_EQ(tp.write(iov.data(), static_cast<int>(iov.size())), PROCESS_SUCCESS);
+  EXPECT_EQ(tp.write(iov.data(), 0), PROCESS_FAIL);
+
+  std::vector<char> data(4096);
+  uint32_t len = 0;
+  ASSERT_EQ(tp.read(data.data(), len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(std::string(data.data(), len), header + payload);
+}
+
+TEST(test_dawn, shmTpReaderCursorPolicy)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_cursor_block");
+  shmTopicSegment::remove("dawn_cursor_evict");
+  auto readerCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  readerCfg->ringDepth_ = 16;
+  auto blockCfg = std::make_shared<reliableQosCfg>();
+  blockCfg->fullTimeoutUs_ = 1000;
+  shmTransport reader("dawn_cursor_block", readerCfg);
+  shmTransport writer("dawn_cursor_block", blockCfg);
+
+  uint32_t data = 0;
+  uint32_t len = 0;
+  ASSERT_EQ(writer.write(&data, sizeof(data)), PROCESS_SUCCESS);
+  ASSERT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  //Only the message consumed by reader can be recycled, then publisher times out.
+  uint32_t writeNum = 1;
+  for (; writeNum < 100; writeNum++)
+  {
+    if (writer.write(&writeNum, sizeof(writeNum)) == PROCESS_FAIL)
+    {
+      break;
+    }
+  }
+  EXPECT_EQ(writeNum, 17);
+  for (uint32_t i = 1; i < writeNum; i++)
+  {
+    ASSERT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    ASSERT_EQ(data, i);
+  }
+
+  auto evictCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  evictCfg->fullPolicy_ = qosCfg::FULL_POLICY::EVICT_SLOWEST;
+  shmTransport slowReader("dawn_cursor_evict", readerCfg);
+  shmTransport evictWriter("dawn_cursor_evict", evictCfg);
+  data = 0;
+  ASSERT_EQ(evictWriter.write(&data, sizeof(data)), PROCESS_SUCCESS);
+  ASSERT_EQ(slowReader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  for (uint32_t i = 1; i < 40; i++)
+  {
+    ASSERT_EQ(evictWriter.write(&i, sizeof(i)), PROCESS_SUCCESS);
+  }
+  //Evicted reader restarts from the oldest alive message.
+  ASSERT_EQ(slowReader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(data, 40 - 16);
+
+  //A reader which died before storing its pid can't be evicted, publisher gives up by full timeout.
+  auto evictRing = shmTopicSegment("dawn_cursor_evict").getRingBuffer();
+  auto readerSlotNum = evictRing->ringBuffer_raw_ptr_->readerSlotNum_.load();
+  auto &deadReader = evictRing->ringBuffer_raw_ptr_->readerCursor_[readerSlotNum];
+  deadReader.state_ = shmIndexRingBuffer::READER_BUSY;
+  evictRing->ringBuffer_raw_ptr_->readerSlotNum_ = readerSlotNum + 1;
+  uint32_t failNum = 0;
+  for (uint32_t i = 0; i < 40; i++)
+  {
+    failNum += (evictWriter.write(&i, sizeof(i)) == PROCESS_FAIL) ? 1 : 0;
+  }
+  EXPECT_GT(failNum, 0);
+  deadReader.state_ = shmIndexRingBuffer::READER_FREE;
+  shmTopicSegment::remove("dawn_cursor_block");
+  shmTopicSegment::remove("dawn_cursor_evict");
+}
+
+TEST(test_dawn, shmTpAsyncSubscribe)
+{
+  using namespace dawn;
+  constexpr uint32_t topicNum = 3;
+  constexpr uint32_t msgNum = 200;
+  for (uint32_t i = 0; i < topicNum; i++)
+  {
+    shmTopicSegment::remove("dawn_async_subscribe_" + std::to_string(i));
+  }
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  threadPoolManager manager;
+  auto executor = manager.createThreadPool(2);
+  shmListener listener;
+
+  std::array<uint32_t, topicNum> expect{};
+  std::atomic<uint32_t> receiveNum{0};
+  std::atomic<bool> ordered{true};
+  std::array<std::unique_ptr<shmTransport>, topicNum> writers;
+  std::array<uint32_t, topicNum> ids;
+  for (uint32_t i = 0; i < topicNum; i++)
+  {
+    auto topic = "dawn_async_subscribe_" + std::to_string(i);
+    ids[i] = listener.subscribe(topic, [&, i](const void *data, uint32_t data_len) {
+      //Callbacks of a topic never overlap, so expect[i] needs no lock.
+      if (data_len != sizeof(uint32_t) || *static_cast<const uint32_t*>(data) != expect[i]++)
+      {
+        ordered = false;
+      }
+      receiveNum++;
+    }, executor, cfg);
+    ASSERT_NE(ids[i], SHM_INVALID_INDEX);
+    writers[i] = std::make_unique<shmTransport>(topic, cfg);
+  }
+
+  for (uint32_t n = 0; n < msgNum; n++)
+  {
+    for (auto &writer : writers)
+    {
+      ASSERT_EQ(writer->write(&n, sizeof(n)), PROCESS_SUCCESS);
+    }
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (receiveNum.load() < topicNum * msgNum && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(receiveNum.load(), topicNum * msgNum);
+  EXPECT_TRUE(ordered.load());
+
+  for (auto id : ids)
+  {
+    EXPECT_EQ(listener.unsubscribe(id), PROCESS_SUCCESS);
+  }
+  EXPECT_EQ(listener.unsubscribe(ids[0]), PROCESS_FAIL);
+  uint32_t n = msgNum;
+  ASSERT_EQ(writers[0]->write(&n, sizeof(n)), PROCESS_SUCCESS);
+  std::this_thread::sleep_for(std::chrono::milliseconds(SHM_LISTENER_REFRESH_MS * 3));
+  EXPECT_EQ(receiveNum.load(), topicNum * msgNum);
+  listener.stop();
+  executor->quitAllThreads();
+  for (uint32_t i = 0; i < topicNum; i++)
+  {
+    shmTopicSegment::remove("dawn_async_subscribe_" + std::to_string(i));
+  }
+}
+
+TEST(test_dawn, shmTpWaitSet)
+{
+  using namespace dawn;
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  shmWaitSet waitSet;
+  std::vector<std::shared_ptr<shmTransport>> writers;
+  for (uint32_t i = 0; i < 3; i++)
+  {
+    auto topic = "dawn_wait_set_" + std::to_string(i);
+    ASSERT_EQ(waitSet.attach(std::make_shared<shmTransport>(topic, cfg)), i);
+    writers.emplace_back(std::make_shared<shmTransport>(topic, cfg));
+  }
+  std::vector<uint32_t> readyVec;
+  //Newly attached topics are reported once.
+  ASSERT_EQ(waitSet.waitFor(readyVec, 0), PROCESS_SUCCESS);
+  EXPECT_EQ(readyVec, std::vector<uint32_t>({0, 1, 2}));
+  EXPECT_EQ(waitSet.waitFor(readyVec, 1000), PROCESS_FAIL);
+  EXPECT_TRUE(readyVec.empty());
+
+  uint32_t data = 7, len = 0;
+  ASSERT_EQ(writers[1]->write(&data, sizeof(data)), PROCESS_SUCCESS);
+  ASSERT_EQ(waitSet.waitFor(readyVec, 0), PROCESS_SUCCESS);
+  ASSERT_EQ(readyVec, std::vector<uint32_t>({1}));
+  ASSERT_EQ(waitSet.getTransport(1)->read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(data, 7);
+
+  //One thread blocks on every topic until another process or thread publishes.
+  auto writeFuture = std::async(std::launch::async, [&writers]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint32_t value = 9;
+    return writers[2]->write(&value, sizeof(value));
+    });
+  ASSERT_EQ(waitSet.wait(readyVec), PROCESS_SUCCESS);
+  ASSERT_EQ(readyVec, std::vector<uint32_t>({2}));
+  EXPECT_EQ(writeFuture.get(), PROCESS_SUCCESS);
+  ASSERT_EQ(waitSet.getTransport(2)->read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  EXPECT_EQ(data, 9);
+
+  EXPECT_EQ(waitSet.detach(2), PROCESS_SUCCESS);
+  EXPECT_EQ(waitSet.detach(2), PROCESS_FAIL);
+  EXPECT_EQ(waitSet.size(), 2);
+  ASSERT_EQ(writers[2]->write(&data, sizeof(data)), PROCESS_SUCCESS);
+  EXPECT_EQ(waitSet.waitFor(readyVec, 1000), PROCESS_FAIL);
+}
+
+TEST(test_dawn, shmTpEventFd)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_event_fd");
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  shmTransport reader("dawn_event_fd", cfg);
+  shmTransport writer("dawn_event_fd", cfg);
+  auto eventFd = reader.getEventFd();
+  ASSERT_NE(eventFd, INVALID_VALUE);
+  EXPECT_EQ(reader.getEventFd(), eventFd);
+
+  auto epollFd = epoll_create1(EPOLL_CLOEXEC);
+  ASSERT_NE(epollFd, INVALID_VALUE);
+  struct epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = eventFd;
+  ASSERT_EQ(epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &event), 0);
+
+  //Newly bridged topic is signaled once.
+  ASSERT_EQ(epoll_wait(epollFd, &event, 1, 1000), 1);
+  reader.clearEvent();
+  EXPECT_EQ(epoll_wait(epollFd, &event, 1, 10), 0);
+
+  uint32_t data = 0, len = 0;
+  for (uint32_t round = 1; round <= 3; round++)
+  {
+    ASSERT_EQ(writer.write(&round, sizeof(round)), PROCESS_SUCCESS);
+    ASSERT_EQ(epoll_wait(epollFd, &event, 1, 1000), 1);
+    EXPECT_EQ(event.data.fd, eventFd);
+    reader.clearEvent();
+    ASSERT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    EXPECT_EQ(data, round);
+    EXPECT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_FAIL);
+  }
+  close(epollFd);
+  shmTopicSegment::remove("dawn_event_fd");
+}
+
+TEST(test_dawn, shmTpLatestValue)
+{
+  using namespace dawn;
+  struct stateEstimate
+  {
+    uint64_t  sequence_;
+    double    position_[3];
+    double    check_;
+  };
+  shmLatestTopic::remove("dawn_latest_state");
+  shmLatestValue<stateEstimate> writer("dawn_latest_state");
+  shmLatestValue<stateEstimate> reader("dawn_latest_state");
+  stateEstimate state{};
+  EXPECT_EQ(reader.read(state), PROCESS_FAIL);
+  EXPECT_EQ(reader.readLatest(state), PROCESS_FAIL);
+
+  for (uint64_t i = 1; i <= 3; i++)
+  {
+    ASSERT_EQ(writer.write({i, {1.0 * i, 2.0 * i, 3.0 * i}, 6.0 * i}), PROCESS_SUCCESS);
+  }
+  //Reader only sees the latest value, and only once.
+  ASSERT_EQ(reader.read(state), PROCESS_SUCCESS);
+  EXPECT_EQ(state.sequence_, 3);
+  EXPECT_EQ(reader.read(state), PROCESS_FAIL);
+  uint64_t timeStamp = 0;
+  ASSERT_EQ(reader.readLatest(state, &timeStamp), PROCESS_SUCCESS);
+  EXPECT_EQ(state.sequence_, 3);
+  EXPECT_NE(timeStamp, 0);
+  EXPECT_EQ(reader.getTopic().write(&state, sizeof(state) + 1), PROCESS_FAIL);
+  EXPECT_THROW(shmLatestValue<uint64_t>("dawn_latest_state"), std::runtime_error);
+
+  //Concurrent writers and readers never see a torn value.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> writers;
+  for (uint32_t w = 0; w < 2; w++)
+  {
+    writers.emplace_back([&writer, &stop, w]() {
+      for (uint64_t i = 0; !stop.load(); i++)
+      {
+        double base = static_cast<double>(i * 2 + w);
+        writer.write({i, {base, base, base}, base * 3});
+      }
+    });
+  }
+  auto blockingRead = std::async(std::launch::async, [&reader]() {
+    stateEstimate value{};
+    return reader.read(value, abstractTransport::BLOCKING_TYPE::BLOCK);
+  });
+  for (uint32_t i = 0; i < 10000; i++)
+  {
+    if (reader.readLatest(state) == PROCESS_SUCCESS)
+    {
+      ASSERT_EQ(state.position_[0] + state.position_[1] + state.position_[2], state.check_);
+    }
+  }
+  EXPECT_EQ(blockingRead.get(), PROCESS_SUCCESS);
+  stop = true;
+  for (auto &thread : writers)
+  {
+    thread.join();
+  }
+
+  //A writer which dies mid-write leaves the slot odd, readers and writers give up instead of hanging.
+  struct deadWriterTopic : public shmLatestTopic
+  {
+    using shmLatestTopic::shmLatestTopic;
+    void dieWhileWriting()
+    {
+      slot_raw_ptr_->sequence_.fetch_add(1);
+    }
+    void recordWriter(uint32_t pid)
+    {
+      slot_raw_ptr_->writerPid_ = pid;
+    }
+  };
+  deadWriterTopic deadWriter("dawn_latest_state", sizeof(stateEstimate));
+  deadWriter.dieWhileWriting();
+  uint32_t len = 0;
+  EXPECT_EQ(reader.readLatest(state), PROCESS_FAIL);
+  EXPECT_EQ(reader.getTopic().read(&state, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_FAIL);
+  //Without its process recorded the writer can't be told from a slow one.
+  EXPECT_EQ(writer.write({4, {4.0, 8.0, 12.0}, 24.0}), PROCESS_FAIL);
+
+  //Slot of a dead process is taken over by the next writer.
+  auto childPid = fork();
+  if (childPid == 0)
+  {
+    _exit(0);
+  }
+  ASSERT_GT(childPid, 0);
+  waitpid(childPid, nullptr, 0);
+  deadWriter.recordWriter(static_cast<uint32_t>(childPid));
+  ASSERT_EQ(writer.write({5, {5.0, 10.0, 15.0}, 30.0}), PROCESS_SUCCESS);
+  ASSERT_EQ(reader.readLatest(state), PROCESS_SUCCESS);
+  EXPECT_EQ(state.sequence_, 5);
+  shmLatestTopic::remove("dawn_latest_state");
+}
+
+TEST(test_dawn, shmTpKeyedTopic)
+{
+  using namespace dawn;
+  struct trackState
+  {
+    uint64_t  trackId_;
+    uint64_t  update_;
+  };
+  shmKeyedTopic::remove("dawn_keyed_track");
+  shmKeyedTopic writer("dawn_keyed_track", 100, sizeof(trackState));
+  shmKeyedTopic reader("dawn_keyed_track", 1, 1);
+  EXPECT_EQ(reader.getSlotNum(), 256);
+  EXPECT_EQ(reader.getValueCapacity(), sizeof(trackState));
+
+  //Slow reader sees the newest update of each key once.
+  for (uint64_t update = 1; update <= 50; update++)
+  {
+    for (uint64_t id = 0; id < 10; id++)
+    {
+      trackState state{id, update};
+      ASSERT_EQ(writer.write(id, &state, sizeof(state)), PROCESS_SUCCESS);
+    }
+  }
+  uint64_t cursor = 0;
+  std::map<uint64_t, uint64_t> updateMap;
+  auto collect = [&updateMap](uint64_t key, const void *data, uint32_t data_len) {
+    ASSERT_EQ(data_len, sizeof(trackState));
+    auto state = static_cast<const trackState*>(data);
+    EXPECT_EQ(state->trackId_, key);
+    EXPECT_EQ(updateMap.count(key), 0);
+    updateMap[key] = state->update_;
+  };
+  EXPECT_EQ(reader.readDirty(collect, cursor), 10);
+  ASSERT_EQ(updateMap.size(), 10);
+  for (auto &[key, update] : updateMap)
+  {
+    EXPECT_EQ(update, 50);
+  }
+  EXPECT_EQ(cursor, 500);
+  EXPECT_EQ(reader.readDirty(collect, cursor), 0);
+
+  trackState state{3, 51};
+  ASSERT_EQ(writer.write(3, &state, sizeof(state)), PROCESS_SUCCESS);
+  updateMap.clear();
+  EXPECT_EQ(reader.readDirty(collect, cursor, abstractTransport::BLOCKING_TYPE::BLOCK), 1);
+  EXPECT_EQ(updateMap[3], 51);
+
+  uint32_t len = 0;
+  uint64_t timeStamp = 0;
+  ASSERT_EQ(reader.read(7, &state, len, &timeStamp), PROCESS_SUCCESS);
+  EXPECT_EQ(state.update_, 50);
+  EXPECT_NE(timeStamp, 0);
+  EXPECT_EQ(reader.read(1000, &state, len), PROCESS_FAIL);
+  EXPECT_EQ(writer.write(1, &state, sizeof(state) + 1), PROCESS_FAIL);
+
+  //Every slot can be taken, then new keys are refused.
+  for (uint64_t id = 10; id < reader.getSlotNum(); id++)
+  {
+    ASSERT_EQ(writer.write(id, &state, sizeof(state)), PROCESS_SUCCESS);
+  }
+  EXPECT_EQ(writer.write(reader.getSlotNum(), &state, sizeof(state)), PROCESS_FAIL);
+
+  //A writer which dies mid-write only loses its own key, scans skip it.
+  struct deadWriterTopic : public shmKeyedTopic
+  {
+    using shmKeyedTopic::shmKeyedTopic;
+    void dieWhileWriting(uint64_t key)
+    {
+      findSlot(key, false)->sequence_.fetch_add(1);
+    }
+    void recordWriter(uint64_t key, uint32_t pid)
+    {
+      findSlot(key, false)->writerPid_ = pid;
+    }
+    keyedSlotType* dieWhileClaiming(uint64_t key)
+    {
+      auto slot = findSlot(key, false);
+      slot->state_ = SLOT_CLAIMING;
+      return slot;
+    }
+  };
+  deadWriterTopic deadWriter("dawn_keyed_track", 1, 1);
+  deadWriter.dieWhileWriting(10);
+  EXPECT_EQ(reader.read(10, &state, len), PROCESS_FAIL);
+  ASSERT_EQ(writer.write(6, &state, sizeof(state)), PROCESS_SUCCESS);
+  std::set<uint64_t> dirtyKeys;
+  auto collectKey = [&dirtyKeys](uint64_t key, const void *data, uint32_t data_len) {
+    dirtyKeys.insert(key);
+  };
+  //Keys 10 ... slotNum - 1 and key 6 are dirty, key 10 is skipped.
+  EXPECT_EQ(reader.readDirty(collectKey, cursor), reader.getSlotNum() - 10);
+  EXPECT_EQ(dirtyKeys.count(10), 0);
+  EXPECT_EQ(dirtyKeys.count(6), 1);
+
+  //Its key can't be written until its process is known dead, then the next writer takes the slot over.
+  EXPECT_EQ(writer.write(10, &state, sizeof(state)), PROCESS_FAIL);
+  auto childPid = fork();
+  if (childPid == 0)
+  {
+    _exit(0);
+  }
+  ASSERT_GT(childPid, 0);
+  waitpid(childPid, nullptr, 0);
+  deadWriter.recordWriter(10, static_cast<uint32_t>(childPid));
+  state.update_ = 52;
+  ASSERT_EQ(writer.write(10, &state, sizeof(state)), PROCESS_SUCCESS);
+  ASSERT_EQ(reader.read(10, &state, len), PROCESS_SUCCESS);
+  EXPECT_EQ(state.update_, 52);
+
+  //A writer which dies while claiming a slot doesn't stop probes of readers and writers.
+  auto claimingSlot = deadWriter.dieWhileClaiming(3);
+  EXPECT_EQ(reader.read(3, &state, len), PROCESS_FAIL);
+  EXPECT_EQ(writer.write(3, &state, sizeof(state)), PROCESS_FAIL);
+  ASSERT_EQ(reader.read(7, &state, len), PROCESS_SUCCESS);
+  claimingSlot->state_ = shmKeyedTopic::SLOT_USED;
+  shmKeyedTopic::remove("dawn_keyed_track");
+}
+
+TEST(test_dawn, shmTpAllocWaitSpace)
+{
+  using namespace dawn;
+  //Two blocks of pool are both borrowed, so nothing can be recycled.
+  auto cfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::EFFICIENT);
+  cfg->shmPoolCfgVec_.emplace_back(qosCfg::shmPoolCfg{SHM_SIZE_CLASS_64B, 2});
+  cfg->ringDepth_ = 16;
+  shmTransport tp("dawn_alloc_wait_space", cfg);
+  uint64_t data = 1;
+  shmBorrowedMsg borrowedMsg[2];
+  for (auto &msg : borrowedMsg)
+  {
+    ASSERT_EQ(tp.write(&data, sizeof(data)), PROCESS_SUCCESS);
+    ASSERT_EQ(tp.borrow(msg, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    data++;
+  }
+  EXPECT_EQ(tp.write(&data, sizeof(data)), PROCESS_FAIL);
+  std::vector<char> tooLarge(SHM_SIZE_CLASS_64B * 3);
+  EXPECT_EQ(tp.write(tooLarge.data(), tooLarge.size()), PROCESS_FAIL);
+
+  //Publisher waiting for space gets the block given back by reader.
+  auto waitCfg = std::make_shared<qosCfg>(*cfg);
+  waitCfg->allocTimeoutUs_ = 1000 * 1000;
+  shmTransport waitTp("dawn_alloc_wait_space", waitCfg);
+  auto releaseFuture = std::async(std::launch::async, [&borrowedMsg]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    borrowedMsg[0].release();
+  });
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(waitTp.write(&data, sizeof(data)), PROCESS_SUCCESS);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+  releaseFuture.get();
+
+  //Deadline bounds the wait.
+  ASSERT_EQ(tp.borrow(borrowedMsg[0], abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  waitCfg->allocTimeoutUs_ = 10 * 1000;
+  shmTransport shortWaitTp("dawn_alloc_wait_space", waitCfg);
+  start = std::chrono::steady_clock::now();
+  EXPECT_EQ(shortWaitTp.write(&data, sizeof(data)), PROCESS_FAIL);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+}
+
+TEST(test_dawn, shmTpBackgroundReclaim)
+{
+  using namespace dawn;
+  shmTopicSegment::remove("dawn_reclaim_depth");
+  shmTopicSegment::remove("dawn_reclaim_lifespan");
+  shmTopicSegment::remove("dawn_reclaim_reader");
+  auto depthCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  depthCfg->ringDepth_ = 16;
+  depthCfg->historyDepth_ = 4;
+  shmTransport depthTp("dawn_reclaim_depth", depthCfg);
+  auto depthRing = shmTopicSegment("dawn_reclaim_depth").getRingBuffer();
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    ASSERT_EQ(depthTp.write(&i, sizeof(i)), PROCESS_SUCCESS);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  uint64_t startIndex;
+  shmIndexRingBuffer::ringBufferIndexBlockType block;
+  ASSERT_EQ(depthRing->getStartIndex(startIndex, block), PROCESS_SUCCESS);
+  EXPECT_EQ(depthRing->getEndIndex() - startIndex, 4);
+
+  auto lifespanCfg = std::make_shared<qosCfg>();
+  lifespanCfg->lifespanUs_ = 2000;
+  shmTransport lifespanTp("dawn_reclaim_lifespan", lifespanCfg);
+  auto lifespanRing = shmTopicSegment("dawn_reclaim_lifespan").getRingBuffer();
+  for (uint32_t i = 0; i < 5; i++)
+  {
+    ASSERT_EQ(lifespanTp.write(&i, sizeof(i)), PROCESS_SUCCESS);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(lifespanRing->getStartIndex(startIndex, block), PROCESS_FAIL);
+
+  //Messages unread by a reliable reader outlive history depth.
+  auto readerCfg = std::make_shared<qosCfg>(qosCfg::QOS_TYPE::RELIABLE);
+  auto writerCfg = std::make_shared<reliableQosCfg>();
+  writerCfg->historyDepth_ = 2;
+  shmTransport reader("dawn_reclaim_reader", readerCfg);
+  shmTransport writer("dawn_reclaim_reader", writerCfg);
+  auto readerRing = shmTopicSegment("dawn_reclaim_reader").getRingBuffer();
+  uint32_t data = 0;
+  uint32_t len = 0;
+  ASSERT_EQ(writer.write(&data, sizeof(data)), PROCESS_SUCCESS);
+  ASSERT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+  for (uint32_t i = 1; i <= 6; i++)
+  {
+    ASSERT_EQ(writer.write(&i, sizeof(i)), PROCESS_SUCCESS);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_EQ(readerRing->getStartIndex(startIndex, block), PROCESS_SUCCESS);
+  EXPECT_EQ(readerRing->getEndIndex() - startIndex, 6);
+  for (uint32_t i = 1; i <= 3; i++)
+  {
+    ASSERT_EQ(reader.read(&data, len, abstractTransport::BLOCKING_TYPE::NON_BLOCK), PROCESS_SUCCESS);
+    ASSERT_EQ(data, i);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_EQ(readerRing->getStartIndex(startIndex, block), PROCESS_SUCCESS);
+  EXPECT_EQ(readerRing->getEndIndex() - startIndex, 3);
+  shmTopicSegment::remove("dawn_reclaim_depth");
+  shmTopicSegment::remove("dawn_reclaim_lifespan");
+  shmTopicSegment::remove("dawn_reclaim_reader");
+}